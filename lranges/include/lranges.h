@@ -1,11 +1,37 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <initializer_list>
 #include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+#include <coroutine>
+#include <exception>
+#define LRANGES_HAS_COROUTINES 1
+#endif
+#endif
 
 namespace lranges {
+
+template <typename Iterator> struct iterator_range;
+
 namespace detail {
 
 namespace meta {
@@ -50,58 +76,277 @@ template <typename T> struct dereference<T&> {
 
 template <typename T> using dereference_t = typename dereference<T>::type;
 
-template <typename T> dereference_t<T> forward_dereferenced(T&& t) { return std::forward<T>(t); }
+template <typename T> constexpr dereference_t<T> forward_dereferenced(T&& t)
+{
+    return std::forward<T>(t);
+}
+
+template <typename... Ts> struct void_type {
+    using type = void;
+};
+
+template <typename... Ts> using void_t = typename void_type<Ts...>::type;
+
+template <typename T, typename = void> struct has_source : std::false_type {
+};
+
+template <typename T>
+struct has_source<T, void_t<decltype(std::declval<T&>().source())>> : std::true_type {
+};
+
+template <typename T, typename = void> struct has_reversed : std::false_type {
+};
+
+template <typename T>
+struct has_reversed<T, void_t<decltype(std::declval<T&>().reversed())>> : std::true_type {
+};
+
+template <typename ReducerT, typename R, typename = void> struct has_remove : std::false_type {
+};
+
+template <typename ReducerT, typename R>
+struct has_remove<ReducerT, R,
+    void_t<decltype(std::declval<const ReducerT&>().remove(
+        std::declval<R&>(), std::declval<const R&>()))>> : std::true_type {
+};
+
+template <typename RangeT> using iterator_t = decltype(std::declval<RangeT&>().begin());
+
+template <typename IteratorT>
+using is_single_pass = std::is_same<typename std::iterator_traits<IteratorT>::iterator_category,
+    std::input_iterator_tag>;
+
+template <std::size_t N> struct priority : priority<N - 1> {
+};
+
+template <> struct priority<0> {
+};
 
 } // namespace meta
 
+/*Upper bound of the number of elements in a range, 0 when it cannot be computed cheaply*/
+template <typename RangeT>
+constexpr auto size_hint(const RangeT& r, meta::priority<3>) -> decltype(std::size_t(r.size_hint()))
+{
+    return r.size_hint();
+}
+template <typename RangeT>
+constexpr auto size_hint(const RangeT& r, meta::priority<2>) -> decltype(std::size_t(r.size()))
+{
+    return r.size();
+}
+template <typename RangeT>
+constexpr auto size_hint(const RangeT& r, meta::priority<1>)
+    -> decltype(std::size_t(r.end() - r.begin()))
+{
+    return static_cast<std::size_t>(r.end() - r.begin());
+}
+template <typename RangeT> constexpr std::size_t size_hint(const RangeT&, meta::priority<0>)
+{
+    return 0;
+}
+template <typename RangeT> constexpr std::size_t size_hint(const RangeT& r)
+{
+    return size_hint(r, meta::priority<3> {});
+}
+
+/*Pipeline stages expose the innermost source range and can be positioned on it*/
+template <typename RangeT> constexpr decltype(auto) source_of(RangeT& r, std::true_type)
+{
+    return r.source();
+}
+template <typename RangeT> constexpr RangeT& source_of(RangeT& r, std::false_type) { return r; }
+
+template <typename RangeT, typename SourceIt>
+constexpr auto iterator_at_source(RangeT& r, SourceIt it, std::true_type)
+{
+    return r.iterator_at(std::move(it));
+}
+template <typename RangeT, typename SourceIt>
+constexpr SourceIt iterator_at_source(RangeT&, SourceIt it, std::false_type)
+{
+    return it;
+}
+
+template <typename RangeT> struct Range;
+template <typename RangeT> struct ReversedRange;
+
+/*Reversal is pushed down through the stages to the source, so filters scan backwards from the
+end of the source just as they scan forward otherwise*/
+template <typename SelfT, typename InnerT>
+constexpr auto reversed_range(SelfT&&, InnerT&& inner, std::true_type)
+{
+    using reversed = decltype(std::forward<InnerT>(inner).reversed());
+    return Range<reversed>(std::forward<InnerT>(inner).reversed());
+}
+template <typename SelfT, typename InnerT>
+constexpr auto reversed_range(SelfT&& self, InnerT&&, std::false_type)
+{
+    using reversed = ReversedRange<std::decay_t<SelfT>>;
+    return Range<reversed>(reversed(std::forward<SelfT>(self)));
+}
+
+/*A copy of the stages of a pipeline over the slice [first, last) of its source, slices of one
+source can thus be evaluated independently*/
+template <typename RangeT, typename SourceIt>
+constexpr auto rebased_range(const RangeT& r, SourceIt first, SourceIt last, std::true_type)
+{
+    using rebased = decltype(r.rebased(first, last));
+    return Range<rebased>(r.rebased(std::move(first), std::move(last)));
+}
+template <typename RangeT, typename SourceIt>
+constexpr auto rebased_range(const RangeT&, SourceIt first, SourceIt last, std::false_type)
+{
+    using slice = iterator_range<SourceIt>;
+    return Range<slice>(slice(std::move(first), std::move(last)));
+}
+
 template <typename T> struct TD;
 
+/*A const pipeline only hands out const_iterators, which reach the user supplied functions and
+owned sources through const access paths. Iterating a const pipeline over a const source from
+several threads at once is therefore safe, as long as the const call operators of the functions
+are.*/
 template <typename RangeT> struct Range : private RangeT {
 
-    Range()        = default;
-    Range(Range&)  = default;
+    Range()             = default;
+    Range(const Range&) = default;
     Range(Range&&) = default;
     Range& operator=(const Range&) = default;
     Range& operator=(Range&&) = default;
 
-    explicit Range(RangeT r)
+    constexpr explicit Range(RangeT r)
         : RangeT(std::move(r))
     {
     }
 
-    using iterator = typename RangeT::iterator;
+    using iterator       = meta::iterator_t<RangeT>;
+    using const_iterator = meta::iterator_t<const RangeT>;
 
-    auto begin() { return range().begin(); }
-    auto end() { return range().end(); }
-    auto begin() const { return range().begin(); }
-    auto end() const { return range().end(); }
+    constexpr auto begin() { return range().begin(); }
+    constexpr auto end() { return range().end(); }
+    constexpr auto begin() const { return range().begin(); }
+    constexpr auto end() const { return range().end(); }
+
+    constexpr std::size_t    size_hint() const { return detail::size_hint(range()); }
+    constexpr decltype(auto) source() { return source_of(range(), meta::has_source<RangeT> {}); }
+    template <typename SourceIt> constexpr auto iterator_at(SourceIt it)
+    {
+        return iterator_at_source(range(), std::move(it), meta::has_source<RangeT> {});
+    }
+    template <typename SourceIt> constexpr auto rebased(SourceIt first, SourceIt last) const
+    {
+        return rebased_range(
+            range(), std::move(first), std::move(last), meta::has_source<RangeT> {});
+    }
+    // reversing an lvalue pipeline borrows the owned source instead of copying it
+    constexpr auto reversed() const&
+    {
+        return reversed_range(
+            Range<const RangeT&>(range()), range(), meta::has_reversed<RangeT> {});
+    }
+    constexpr auto reversed() &&
+    {
+        return reversed_range(std::move(*this), std::move(range()), meta::has_reversed<RangeT> {});
+    }
 
 private:
-    RangeT&       range() { return static_cast<RangeT&>(*this); }
-    const RangeT& range() const { return static_cast<const RangeT&>(*this); }
+    constexpr RangeT&       range() { return static_cast<RangeT&>(*this); }
+    constexpr const RangeT& range() const { return static_cast<const RangeT&>(*this); }
 };
 
 template <typename RangeT> struct Range<RangeT&> {
-    Range()        = default;
-    Range(Range&)  = default;
+    Range()             = default;
+    Range(const Range&) = default;
     Range(Range&&) = default;
     Range& operator=(const Range&) = default;
     Range& operator=(Range&&) = default;
 
-    explicit Range(RangeT& _r)
+    constexpr explicit Range(RangeT& _r)
         : r { &_r }
     {
     }
-    using iterator = typename RangeT::iterator;
+    using iterator       = meta::iterator_t<RangeT>;
+    using const_iterator = iterator;
+    constexpr auto begin() { return r->begin(); }
+    constexpr auto end() { return r->end(); }
+    constexpr auto begin() const { return r->begin(); }
+    constexpr auto end() const { return r->end(); }
+
+    constexpr std::size_t    size_hint() const { return detail::size_hint(*r); }
+    constexpr decltype(auto) source() { return source_of(*r, meta::has_source<RangeT> {}); }
+    template <typename SourceIt> constexpr auto iterator_at(SourceIt it)
+    {
+        return iterator_at_source(*r, std::move(it), meta::has_source<RangeT> {});
+    }
+    template <typename SourceIt> constexpr auto rebased(SourceIt first, SourceIt last) const
+    {
+        return rebased_range(*r, std::move(first), std::move(last), meta::has_source<RangeT> {});
+    }
+    constexpr auto reversed() const
+    {
+        return reversed_range(*this, static_cast<const RangeT&>(*r), meta::has_reversed<RangeT> {});
+    }
+
+private:
+    RangeT* r = nullptr;
+};
+
+/*Source held through a reference count, copies of a pipeline over it share the elements. Like
+an owned source it is only reached through const access from a const pipeline.*/
+template <typename RangeT> struct SharedRange {
+
+    explicit SharedRange(std::shared_ptr<RangeT> _r)
+        : r { std::move(_r) }
+    {
+    }
+
+    using iterator       = meta::iterator_t<RangeT>;
+    using const_iterator = meta::iterator_t<const RangeT>;
+
     auto begin() { return r->begin(); }
     auto end() { return r->end(); }
-    auto begin() const { return r->begin(); }
-    auto end() const { return r->end(); }
+    auto begin() const { return shared().begin(); }
+    auto end() const { return shared().end(); }
+
+    std::size_t    size_hint() const { return detail::size_hint(shared()); }
+    decltype(auto) source() { return source_of(*r, meta::has_source<RangeT> {}); }
+    template <typename SourceIt> auto iterator_at(SourceIt it)
+    {
+        return iterator_at_source(*r, std::move(it), meta::has_source<RangeT> {});
+    }
+    template <typename SourceIt> auto rebased(SourceIt first, SourceIt last) const
+    {
+        return rebased_range(
+            shared(), std::move(first), std::move(last), meta::has_source<RangeT> {});
+    }
 
 private:
-    RangeT* r = nullptr;
+    const RangeT& shared() const { return *r; }
+
+    std::shared_ptr<RangeT> r;
 };
 
+/*Result of it++ on single-pass iterators. Their copies share the position of the original, so
+*it++ reads the value taken before the increment from here.*/
+template <typename T> struct PostIncrementProxy {
+    constexpr const T& operator*() const { return value; }
+    T                  value;
+};
+
+template <typename IteratorT> constexpr auto post_increment(IteratorT& it, std::false_type)
+{
+    auto temp = it;
+    ++it;
+    return temp;
+}
+template <typename IteratorT> constexpr auto post_increment(IteratorT& it, std::true_type)
+{
+    PostIncrementProxy<std::decay_t<decltype(*it)>> old { *it };
+    ++it;
+    return old;
+}
+
 template <typename IteratorWrapperT, typename IteratorT> struct bidir_iterator_api {
 
     using traits            = std::iterator_traits<IteratorT>;
@@ -111,43 +356,41 @@ template <typename IteratorWrapperT, typename IteratorT> struct bidir_iterator_a
     using reference         = typename traits::reference;
     using pointer           = typename traits::pointer;
 
-    IteratorWrapperT*       _this() noexcept { return static_cast<IteratorWrapperT*>(this); }
-    const IteratorWrapperT* _this() const noexcept
+    constexpr IteratorWrapperT* _this() noexcept { return static_cast<IteratorWrapperT*>(this); }
+    constexpr const IteratorWrapperT* _this() const noexcept
     {
         return static_cast<const IteratorWrapperT*>(this);
     }
 
-    explicit bidir_iterator_api(IteratorT it_)
+    constexpr explicit bidir_iterator_api(IteratorT it_)
         : it { std::move(it_) }
     {
     }
     /*Iterator API (Input, Forward)*/
-    decltype(auto) operator*() { return _this()->dereference(*it); }
-    decltype(auto) operator*() const { return _this()->dereference(*it); }
-    auto           operator==(const bidir_iterator_api& rhs) const { return it == rhs.it; }
-    auto           operator!=(const bidir_iterator_api& rhs) const { return !((*this) == rhs); }
+    constexpr decltype(auto) operator*() { return _this()->dereference(*it); }
+    constexpr decltype(auto) operator*() const { return _this()->dereference(*it); }
+    constexpr auto operator==(const bidir_iterator_api& rhs) const { return it == rhs.it; }
+    constexpr auto operator!=(const bidir_iterator_api& rhs) const { return !((*this) == rhs); }
 
-    decltype(auto) operator++()
+    constexpr decltype(auto) operator++()
     {
         ++it;
         _this()->advance();
         return *this;
     }
-    auto operator++(int)
+    constexpr auto operator++(int)
     {
-        auto temp = *_this();
-        ++(*this);
-        return temp;
+        return post_increment(*_this(), meta::is_single_pass<IteratorT> {});
     }
 
     /*Bi-directional iterator API*/
-    decltype(auto) operator--()
+    constexpr decltype(auto) operator--()
     {
         --it;
         _this()->backward();
         return *this;
     }
-    auto operator--(int)
+    constexpr auto operator--(int)
     {
         auto temp = *_this();
         --(*this);
@@ -163,8 +406,8 @@ struct random_access_iterator_api : public bidir_iterator_api<IteratorWrapperT,
     using my_base         = bidir_iterator_api<IteratorWrapperT, IteratorT>;
     using difference_type = typename my_base::difference_type;
 
-    IteratorWrapperT*       _this() noexcept { return static_cast<IteratorWrapperT*>(this); }
-    const IteratorWrapperT* _this() const noexcept
+    constexpr IteratorWrapperT* _this() noexcept { return static_cast<IteratorWrapperT*>(this); }
+    constexpr const IteratorWrapperT* _this() const noexcept
     {
         return static_cast<const IteratorWrapperT*>(this);
     }
@@ -172,28 +415,52 @@ struct random_access_iterator_api : public bidir_iterator_api<IteratorWrapperT,
     using bidir_iterator_api<IteratorWrapperT, IteratorT>::bidir_iterator_api;
 
     /*Random-access API*/
-    decltype(auto) operator+=(difference_type n)
+    constexpr decltype(auto) operator+=(difference_type n)
     {
         this->it += n;
         return *this;
     }
-    decltype(auto) operator-=(difference_type n)
+    constexpr decltype(auto) operator-=(difference_type n)
     {
         this->it -= n;
         return *this;
     }
-    decltype(auto) operator[](difference_type n) { return _this()->dereference(this->it[n]); }
-    decltype(auto) operator[](difference_type n) const { return _this()->derefence(this->it[n]); }
-    auto operator-(const random_access_iterator_api& rhs) const { return this->it - rhs.it; }
-    auto operator<(const random_access_iterator_api& rhs) const { return this->it < rhs.it; }
-    auto operator<=(const random_access_iterator_api& rhs) const { return this->it <= rhs.it; }
-    auto operator>(const random_access_iterator_api& rhs) const { return this->it > rhs.it; }
-    auto operator>=(const random_access_iterator_api& rhs) const { return this->it >= rhs.it; }
+    constexpr decltype(auto) operator[](difference_type n)
+    {
+        return _this()->dereference(this->it[n]);
+    }
+    constexpr decltype(auto) operator[](difference_type n) const
+    {
+        return _this()->dereference(this->it[n]);
+    }
+    // SFINAE-friendly so that size_hint() can probe pipelines over non-random-access sources
+    template <typename I = IteratorT>
+    constexpr auto operator-(const random_access_iterator_api& rhs) const
+        -> decltype(std::declval<const I&>() - std::declval<const I&>())
+    {
+        return this->it - rhs.it;
+    }
+    constexpr auto operator<(const random_access_iterator_api& rhs) const
+    {
+        return this->it < rhs.it;
+    }
+    constexpr auto operator<=(const random_access_iterator_api& rhs) const
+    {
+        return this->it <= rhs.it;
+    }
+    constexpr auto operator>(const random_access_iterator_api& rhs) const
+    {
+        return this->it > rhs.it;
+    }
+    constexpr auto operator>=(const random_access_iterator_api& rhs) const
+    {
+        return this->it >= rhs.it;
+    }
 };
 
 /*Random-access API*/
 template <typename IW, typename I>
-auto operator-(random_access_iterator_api<IW, I> const&         it,
+constexpr auto operator-(random_access_iterator_api<IW, I> const&         it,
     typename random_access_iterator_api<IW, I>::difference_type n)
 {
     auto temp = *it._this();
@@ -202,7 +469,7 @@ auto operator-(random_access_iterator_api<IW, I> const&         it,
 }
 
 template <typename IW, typename I>
-auto operator+(random_access_iterator_api<IW, I> const&         it,
+constexpr auto operator+(random_access_iterator_api<IW, I> const& it,
     typename random_access_iterator_api<IW, I>::difference_type n)
 {
     auto temp = *it._this();
@@ -210,177 +477,462 @@ auto operator+(random_access_iterator_api<IW, I> const&         it,
     return temp;
 }
 template <typename IW, typename I>
-auto operator+(typename random_access_iterator_api<IW, I>::difference_type n,
+constexpr auto operator+(typename random_access_iterator_api<IW, I>::difference_type n,
     random_access_iterator_api<IW, I> const&                               it)
 {
     return it + n;
 }
 
-template <typename RangeT, typename TransformationT> struct TransformationIterator;
+template <typename SequenceT> struct TransformationIterator;
 
 template <typename RangeT, typename TransformationT>
 struct TransformedRange : private RangeT, private TransformationT {
 
-    using iterator = TransformationIterator<RangeT, TransformationT>;
+    using iterator       = TransformationIterator<TransformedRange>;
+    using const_iterator = TransformationIterator<const TransformedRange>;
 
-    TransformedRange(RangeT l, TransformationT r)
+    constexpr TransformedRange(RangeT l, TransformationT r)
         : RangeT { std::move(l) }
         , TransformationT { std::move(r) }
     {
     }
 
-    auto begin() { return iterator(*this, range().begin()); }
-    auto end() { return iterator(*this, range().end()); }
+    constexpr auto begin() { return iterator(*this, range().begin()); }
+    constexpr auto end() { return iterator(*this, range().end()); }
+    constexpr auto begin() const { return const_iterator(*this, range().begin()); }
+    constexpr auto end() const { return const_iterator(*this, range().end()); }
 
-    decltype(auto) transformation() { return static_cast<TransformationT&>(*this); }
-    decltype(auto) transformation() const { return static_cast<const TransformationT&>(*this); }
-    decltype(auto) range() { return static_cast<RangeT&>(*this); }
-    decltype(auto) range() const { return static_cast<const RangeT&>(*this); }
+    constexpr std::size_t    size_hint() const { return range().size_hint(); }
+    constexpr decltype(auto) source() { return range().source(); }
+    template <typename SourceIt> constexpr auto iterator_at(SourceIt it)
+    {
+        return iterator(*this, range().iterator_at(std::move(it)));
+    }
+    template <typename SourceIt> constexpr auto rebased(SourceIt first, SourceIt last) const
+    {
+        using rebased = decltype(range().rebased(first, last));
+        return TransformedRange<rebased, TransformationT>(
+            range().rebased(std::move(first), std::move(last)), transformation());
+    }
+    constexpr auto reversed() const&
+    {
+        using reversed = decltype(range().reversed());
+        return TransformedRange<reversed, TransformationT>(range().reversed(), transformation());
+    }
+    constexpr auto reversed() &&
+    {
+        using reversed = decltype(std::move(range()).reversed());
+        return TransformedRange<reversed, TransformationT>(
+            std::move(range()).reversed(), std::move(transformation()));
+    }
+
+    constexpr decltype(auto) transformation() { return static_cast<TransformationT&>(*this); }
+    constexpr decltype(auto) transformation() const
+    {
+        return static_cast<const TransformationT&>(*this);
+    }
+    constexpr decltype(auto) range() { return static_cast<RangeT&>(*this); }
+    constexpr decltype(auto) range() const { return static_cast<const RangeT&>(*this); }
 };
 
-template <typename RangeT, typename TransformationT>
+template <typename SequenceT>
 struct TransformationIterator
-    : public random_access_iterator_api<TransformationIterator<RangeT, TransformationT>,
-          typename RangeT::iterator> {
+    : public random_access_iterator_api<TransformationIterator<SequenceT>,
+          meta::iterator_t<decltype(std::declval<SequenceT&>().range())>> {
 
-    using my_base    = random_access_iterator_api<TransformationIterator<RangeT, TransformationT>,
-        typename RangeT::iterator>;
-    using iterator   = typename RangeT::iterator;
-    using traits     = std::iterator_traits<iterator>;
-    using value_type = std::remove_reference_t<decltype(
-        std::declval<TransformationT>()(std::declval<typename traits::value_type>()))>;
-    using reference  = std::add_lvalue_reference_t<value_type>;
-    using pointer    = std::add_pointer_t<value_type>;
+    using iterator = meta::iterator_t<decltype(std::declval<SequenceT&>().range())>;
+    using my_base  = random_access_iterator_api<TransformationIterator<SequenceT>, iterator>;
 
-    using sequence_t = TransformedRange<RangeT, TransformationT>;
+    using traits           = std::iterator_traits<iterator>;
+    using transformation_t = decltype(std::declval<SequenceT&>().transformation());
+    using value_type       = std::remove_reference_t<decltype(
+        std::declval<transformation_t>()(std::declval<typename traits::value_type>()))>;
+    using reference        = std::add_lvalue_reference_t<value_type>;
+    using pointer          = std::add_pointer_t<value_type>;
 
-    TransformationIterator(sequence_t& _seq, iterator _it)
-        : seq { &_seq }
-        , my_base { std::move(_it) }
+    using sequence_t = SequenceT;
+
+    constexpr TransformationIterator(sequence_t& _seq, iterator _it)
+        : my_base { std::move(_it) }
+        , seq { &_seq }
     {
     }
 
-    template <typename U> decltype(auto) dereference(U&& u)
+    template <typename U> constexpr decltype(auto) dereference(U&& u)
     {
         return meta::forward_dereferenced(seq->transformation()(std::forward<U>(u)));
     }
 
-    template <typename U> decltype(auto) dereference(U&& u) const
+    template <typename U> constexpr decltype(auto) dereference(U&& u) const
     {
         return meta::forward_dereferenced(seq->transformation()(std::forward<U>(u)));
     }
 
-    void advance() {}
-    void backward() {}
+    constexpr void advance() {}
+    constexpr void backward() {}
 
     sequence_t* seq;
 };
 
-template <typename RangeT, typename FilterPredicate> struct FilterIterator;
+template <typename SequenceT> struct FilterIterator;
 
 template <typename RangeT, typename FilterPredicate>
 struct FilteredRange : private RangeT, private FilterPredicate {
 
-    using iterator = FilterIterator<RangeT, FilterPredicate>;
+    using iterator       = FilterIterator<FilteredRange>;
+    using const_iterator = FilterIterator<const FilteredRange>;
 
-    FilteredRange(RangeT l, FilterPredicate r)
+    constexpr FilteredRange(RangeT l, FilterPredicate r)
         : RangeT { std::move(l) }
         , FilterPredicate { std::move(r) }
     {
     }
 
-    auto           begin() { return iterator(*this, range().begin()); }
-    auto           end() { return iterator(*this, range().end()); }
-    decltype(auto) filter() { return static_cast<FilterPredicate&>(*this); }
-    decltype(auto) filter() const { return static_cast<const FilterPredicate&>(*this); }
-    decltype(auto) range() { return static_cast<RangeT&>(*this); }
-    decltype(auto) range() const { return static_cast<const RangeT&>(*this); }
+    constexpr auto           begin() { return iterator(*this, range().begin()); }
+    constexpr auto           end() { return iterator(*this, range().end()); }
+    constexpr auto           begin() const { return const_iterator(*this, range().begin()); }
+    constexpr auto           end() const { return const_iterator(*this, range().end()); }
+    constexpr std::size_t    size_hint() const { return range().size_hint(); }
+    constexpr decltype(auto) source() { return range().source(); }
+    template <typename SourceIt> constexpr auto iterator_at(SourceIt it)
+    {
+        return iterator(*this, range().iterator_at(std::move(it)));
+    }
+    template <typename SourceIt> constexpr auto rebased(SourceIt first, SourceIt last) const
+    {
+        using rebased = decltype(range().rebased(first, last));
+        return FilteredRange<rebased, FilterPredicate>(
+            range().rebased(std::move(first), std::move(last)), filter());
+    }
+    constexpr auto reversed() const&
+    {
+        using reversed = decltype(range().reversed());
+        return FilteredRange<reversed, FilterPredicate>(range().reversed(), filter());
+    }
+    constexpr auto reversed() &&
+    {
+        using reversed = decltype(std::move(range()).reversed());
+        return FilteredRange<reversed, FilterPredicate>(
+            std::move(range()).reversed(), std::move(filter()));
+    }
+    constexpr decltype(auto) filter() { return static_cast<FilterPredicate&>(*this); }
+    constexpr decltype(auto) filter() const { return static_cast<const FilterPredicate&>(*this); }
+    constexpr decltype(auto) range() { return static_cast<RangeT&>(*this); }
+    constexpr decltype(auto) range() const { return static_cast<const RangeT&>(*this); }
 
 private:
 };
 
-template <typename RangeT, typename FilterPredicate>
-struct FilterIterator : public bidir_iterator_api<FilterIterator<RangeT, FilterPredicate>,
-                            typename RangeT::iterator> {
+template <typename SequenceT>
+struct FilterIterator : public bidir_iterator_api<FilterIterator<SequenceT>,
+                            meta::iterator_t<decltype(std::declval<SequenceT&>().range())>> {
 
-    using my_base
-        = bidir_iterator_api<FilterIterator<RangeT, FilterPredicate>, typename RangeT::iterator>;
-    using iterator = typename RangeT::iterator;
+    using iterator = meta::iterator_t<decltype(std::declval<SequenceT&>().range())>;
+    using my_base  = bidir_iterator_api<FilterIterator<SequenceT>, iterator>;
     using traits   = std::iterator_traits<iterator>;
     using iterator_category
         = meta::iterator_min_t<typename traits::iterator_category, std::bidirectional_iterator_tag>;
-    using filtered_sequence_t = FilteredRange<RangeT, FilterPredicate>;
+    using filtered_sequence_t = SequenceT;
 
-    FilterIterator(filtered_sequence_t& _seq, iterator _it)
-        : seq { &_seq }
-        , my_base { std::move(_it) }
+    constexpr FilterIterator(filtered_sequence_t& _seq, iterator _it)
+        : my_base { std::move(_it) }
+        , seq { &_seq }
     {
         next();
     }
 
     /*Iterator API (Input, Forward)*/
 
-    template <typename U> decltype(auto) dereference(U&& u)
+    template <typename U> constexpr decltype(auto) dereference(U&& u)
     {
         return meta::forward_dereferenced(std::forward<U>(u));
     }
-    template <typename U> decltype(auto) dereference(U&& u) const
+    template <typename U> constexpr decltype(auto) dereference(U&& u) const
     {
         return meta::forward_dereferenced(std::forward<U>(u));
     }
 
-    void advance() { next(); }
-    void backward() { prev(); }
+    constexpr void advance() { next(); }
+    constexpr void backward() { prev(); }
 
     filtered_sequence_t* seq;
 
 private:
-    void next() { this->it = std::find_if(this->it, seq->range().end(), seq->filter()); }
-    void prev()
+    // std::find_if is not usable in constant expressions before C++20
+    constexpr void next()
     {
-        for (; this->it != seq->range().begin() && !seq->filter()(*this->it); --this->it)
+        for (auto last = seq->range().end(); this->it != last && !seq->filter()(*this->it);
+             ++this->it)
             ;
     }
+    // symmetric to next(), decrementing the iterator of the first match is undefined as usual
+    constexpr void prev()
+    {
+        for (; !seq->filter()(*this->it); --this->it)
+            ;
+    }
+};
+
+template <typename RangeT> struct ReversedRange : private RangeT {
+
+    using iterator = std::reverse_iterator<typename RangeT::iterator>;
+
+    constexpr explicit ReversedRange(RangeT r)
+        : RangeT(std::move(r))
+    {
+    }
+
+    constexpr auto begin() { return iterator(range().end()); }
+    constexpr auto end() { return iterator(range().begin()); }
+    constexpr auto begin() const { return std::make_reverse_iterator(range().end()); }
+    constexpr auto end() const { return std::make_reverse_iterator(range().begin()); }
+
+    constexpr std::size_t size_hint() const { return range().size_hint(); }
+    constexpr RangeT      reversed() const& { return range(); }
+    constexpr RangeT      reversed() && { return std::move(range()); }
+
+private:
+    constexpr RangeT&       range() { return static_cast<RangeT&>(*this); }
+    constexpr const RangeT& range() const { return static_cast<const RangeT&>(*this); }
+};
+
+/*Exponential search for the first element not less than value, touches O(log d) elements of a
+random-access range where d is the distance to the result*/
+template <typename Iterator, typename T, typename CompareT>
+Iterator gallop_lower_bound(Iterator first, Iterator last, const T& value, const CompareT& comp,
+    std::random_access_iterator_tag)
+{
+    if (first == last || !comp(*first, value)) {
+        return first;
+    }
+    const auto n     = last - first;
+    auto       bound = decltype(n)(1);
+    for (; bound < n && comp(first[bound], value); bound *= 2)
+        ;
+    return std::lower_bound(first + bound / 2 + 1, first + std::min(bound, n), value, comp);
+}
+
+template <typename Iterator, typename T, typename CompareT>
+Iterator gallop_lower_bound(
+    Iterator first, Iterator last, const T& value, const CompareT& comp, std::input_iterator_tag)
+{
+    for (; first != last && comp(*first, value); ++first)
+        ;
+    return first;
+}
+
+template <typename Iterator, typename T, typename CompareT>
+Iterator gallop_lower_bound(Iterator first, Iterator last, const T& value, const CompareT& comp)
+{
+    return gallop_lower_bound(std::move(first), std::move(last), value, comp,
+        typename std::iterator_traits<Iterator>::iterator_category {});
+}
+
+/*Set operations on sorted ranges, each keeps the iterator pair on the next element to yield
+and parks both iterators on their ends once exhausted*/
+struct MergeOp {
+    template <typename It> static constexpr void settle(It&) {}
+    template <typename It> static constexpr bool use_first(const It& it)
+    {
+        return it.it2 == it.end2() || (it.it1 != it.end1() && !it.comp()(*it.it2, *it.it1));
+    }
+    template <typename It> static constexpr void increment(It& it)
+    {
+        if (use_first(it)) {
+            ++it.it1;
+        } else {
+            ++it.it2;
+        }
+    }
+    static constexpr std::size_t size_hint(std::size_t a, std::size_t b) { return a + b; }
+};
+
+struct IntersectOp {
+    template <typename It> static void settle(It& it)
+    {
+        while (it.it1 != it.end1() && it.it2 != it.end2()) {
+            decltype(auto) v1 = *it.it1;
+            decltype(auto) v2 = *it.it2;
+            if (it.comp()(v1, v2)) {
+                it.it1 = gallop_lower_bound(it.it1, it.end1(), v2, it.comp());
+            } else if (it.comp()(v2, v1)) {
+                it.it2 = gallop_lower_bound(it.it2, it.end2(), v1, it.comp());
+            } else {
+                return;
+            }
+        }
+        it.it1 = it.end1();
+        it.it2 = it.end2();
+    }
+    template <typename It> static constexpr bool use_first(const It&) { return true; }
+    template <typename It> static void increment(It& it)
+    {
+        ++it.it1;
+        ++it.it2;
+    }
+    static constexpr std::size_t size_hint(std::size_t a, std::size_t b) { return std::min(a, b); }
+};
+
+struct DifferenceOp {
+    template <typename It> static void settle(It& it)
+    {
+        for (; it.it1 != it.end1(); ++it.it1, ++it.it2) {
+            decltype(auto) v1 = *it.it1;
+            it.it2            = gallop_lower_bound(it.it2, it.end2(), v1, it.comp());
+            if (it.it2 == it.end2() || it.comp()(v1, *it.it2)) {
+                return;
+            }
+        }
+        it.it2 = it.end2();
+    }
+    template <typename It> static constexpr bool use_first(const It&) { return true; }
+    template <typename It> static void increment(It& it) { ++it.it1; }
+    static constexpr std::size_t size_hint(std::size_t a, std::size_t) { return a; }
+};
+
+template <typename SequenceT> struct SetOpIterator;
+
+template <typename OpT, typename RangeA, typename RangeB, typename CompareT>
+struct SetOpRange : private CompareT {
+
+    using op             = OpT;
+    using iterator       = SetOpIterator<SetOpRange>;
+    using const_iterator = SetOpIterator<const SetOpRange>;
+
+    constexpr SetOpRange(RangeA _a, RangeB _b, CompareT comp)
+        : CompareT { std::move(comp) }
+        , a { std::move(_a) }
+        , b { std::move(_b) }
+    {
+    }
+
+    constexpr auto begin() { return iterator(*this, first().begin(), second().begin()); }
+    constexpr auto end() { return iterator(*this, first().end(), second().end()); }
+    constexpr auto begin() const
+    {
+        return const_iterator(*this, first().begin(), second().begin());
+    }
+    constexpr auto end() const { return const_iterator(*this, first().end(), second().end()); }
+
+    constexpr std::size_t size_hint() const
+    {
+        return OpT::size_hint(detail::size_hint(a), detail::size_hint(b));
+    }
+
+    constexpr decltype(auto) compare() const { return static_cast<const CompareT&>(*this); }
+    constexpr RangeA&        first() { return a; }
+    constexpr const RangeA&  first() const { return a; }
+    constexpr RangeB&        second() { return b; }
+    constexpr const RangeB&  second() const { return b; }
+
+private:
+    RangeA a;
+    RangeB b;
+};
+
+template <typename SequenceT> struct SetOpIterator {
+
+    using first_iterator  = meta::iterator_t<decltype(std::declval<SequenceT&>().first())>;
+    using second_iterator = meta::iterator_t<decltype(std::declval<SequenceT&>().second())>;
+    using op              = typename std::remove_const_t<SequenceT>::op;
+
+    using first_traits      = std::iterator_traits<first_iterator>;
+    using second_traits     = std::iterator_traits<second_iterator>;
+    using iterator_category = meta::iterator_min_t<std::forward_iterator_tag,
+        meta::iterator_min_t<typename first_traits::iterator_category,
+            typename second_traits::iterator_category>>;
+    using value_type = std::common_type_t<typename first_traits::value_type,
+        typename second_traits::value_type>;
+    using difference_type = std::ptrdiff_t;
+    using reference
+        = std::conditional_t<std::is_same<typename first_traits::reference,
+                                 typename second_traits::reference>::value,
+            typename first_traits::reference, value_type>;
+    using pointer = std::add_pointer_t<std::remove_reference_t<reference>>;
+
+    constexpr SetOpIterator(SequenceT& _seq, first_iterator _it1, second_iterator _it2)
+        : seq { &_seq }
+        , it1 { std::move(_it1) }
+        , it2 { std::move(_it2) }
+    {
+        op::settle(*this);
+    }
+
+    constexpr reference operator*() const
+    {
+        return op::use_first(*this) ? reference(*it1) : reference(*it2);
+    }
+    constexpr bool operator==(const SetOpIterator& rhs) const
+    {
+        return it1 == rhs.it1 && it2 == rhs.it2;
+    }
+    constexpr bool operator!=(const SetOpIterator& rhs) const { return !((*this) == rhs); }
+
+    constexpr SetOpIterator& operator++()
+    {
+        op::increment(*this);
+        op::settle(*this);
+        return *this;
+    }
+    constexpr auto operator++(int)
+    {
+        return post_increment(*this, meta::is_single_pass<SetOpIterator> {});
+    }
+
+    constexpr auto           end1() const { return seq->first().end(); }
+    constexpr auto           end2() const { return seq->second().end(); }
+    constexpr decltype(auto) comp() const { return seq->compare(); }
+
+    SequenceT*      seq;
+    first_iterator  it1;
+    second_iterator it2;
 };
 
 template <typename F, typename = void> struct FuncWrapper : public F {
     FuncWrapper() = default;
-    FuncWrapper(F&& f)
+    constexpr FuncWrapper(F&& f)
         : F(std::move(f))
     {
     }
-    FuncWrapper(const F& f)
+    constexpr FuncWrapper(const F& f)
         : F(f)
     {
     }
 };
 
-template <typename R, typename Arg> struct FuncWrapper<R(Arg)> {
-    using signature = R(Arg);
+template <typename R, typename... Args> struct FuncWrapper<R(Args...)> {
+    using signature = R(Args...);
     FuncWrapper()   = default;
-    explicit FuncWrapper(signature func)
+    constexpr explicit FuncWrapper(signature func)
         : fptr { func }
     {
     }
 
-    template <typename UArg> R operator()(UArg&& arg) const
+    template <typename... UArgs> constexpr R operator()(UArgs&&... args) const
     {
-        return fptr(std::forward<UArg>(arg));
+        return fptr(std::forward<UArgs>(args)...);
     }
 
 private:
     signature* fptr = nullptr;
 };
 
+#if defined(__cpp_noexcept_function_type)
+template <typename R, typename... Args>
+struct FuncWrapper<R(Args...) noexcept> : public FuncWrapper<R(Args...)> {
+    using FuncWrapper<R(Args...)>::FuncWrapper;
+};
+#endif
+
 template <typename PMemFun>
 struct FuncWrapper<PMemFun, std::enable_if_t<std::is_member_function_pointer<PMemFun>::value>> {
     FuncWrapper() = default;
-    explicit FuncWrapper(PMemFun func)
+    constexpr explicit FuncWrapper(PMemFun func)
         : fptr { func }
     {
     }
 
-    template <typename UArg> decltype(auto) operator()(UArg&& arg) const
+    template <typename UArg> constexpr decltype(auto) operator()(UArg&& arg) const
     {
         return (std::forward<UArg>(arg).*fptr)();
     }
@@ -398,52 +950,1720 @@ template <typename F> struct Filter : public FuncWrapper<F> {
 };
 
 template <typename RangeT, typename TransformationT>
-auto operator|(RangeT&& r, Transformation<TransformationT> tf)
+constexpr auto operator|(RangeT&& r, Transformation<TransformationT> tf)
 {
     using range          = Range<RangeT>;
     using transformation = decltype(tf);
     return TransformedRange<range, transformation>(range(std::forward<RangeT>(r)), std::move(tf));
 }
 
-template <typename RangeT, typename FilterT> auto operator|(RangeT&& r, Filter<FilterT> tf)
+template <typename RangeT, typename FilterT>
+constexpr auto operator|(RangeT&& r, Filter<FilterT> tf)
 {
     using range     = Range<RangeT>;
     using predicate = decltype(tf);
     return FilteredRange<range, predicate>(range { std::forward<RangeT>(r) }, std::move(tf));
 }
+
+struct Reverse {
+};
+
+template <typename RangeT> constexpr auto operator|(RangeT&& r, Reverse)
+{
+    return Range<RangeT>(std::forward<RangeT>(r)).reversed();
+}
+
+template <std::size_t N> struct ToArray {
+};
+
+template <typename T, std::size_t N, std::size_t... Is>
+constexpr std::array<T, sizeof...(Is)> to_std_array(const T (&a)[N], std::index_sequence<Is...>)
+{
+    return { { a[Is]... } };
+}
+
+template <typename RangeT, std::size_t N> constexpr auto operator|(RangeT&& r, ToArray<N>)
+{
+    using value_type = std::decay_t<decltype(*r.begin())>;
+    // elements are staged in a plain array as std::array has no constexpr mutators in C++14
+    value_type  buffer[N > 0 ? N : 1] {};
+    std::size_t i = 0;
+    for (auto it = r.begin(), last = r.end(); i < N && it != last; ++it, ++i) {
+        buffer[i] = *it;
+    }
+    return to_std_array(buffer, std::make_index_sequence<N> {});
+}
+template <typename OpT, typename RangeA, typename RangeB, typename CompareT>
+constexpr auto make_set_op(RangeA&& a, RangeB&& b, CompareT&& comp)
+{
+    using compare = FuncWrapper<std::remove_reference_t<CompareT>>;
+    return SetOpRange<OpT, Range<RangeA>, Range<RangeB>, compare>(
+        Range<RangeA>(std::forward<RangeA>(a)), Range<RangeB>(std::forward<RangeB>(b)),
+        compare(std::forward<CompareT>(comp)));
+}
+
 } // namespace detail
 
-template <typename TransformationT> auto transform(TransformationT&& tf)
+template <typename TransformationT> constexpr auto transform(TransformationT&& tf)
 {
     return detail::Transformation<std::remove_reference_t<TransformationT>>(
         std::forward<TransformationT>(tf));
 }
 
-template <typename FilterT> auto filter(FilterT&& tf)
+template <typename FilterT> constexpr auto filter(FilterT&& tf)
 {
     return detail::Filter<std::remove_reference_t<FilterT>>(std::forward<FilterT>(tf));
 }
 
+// Stage iterating a bidirectional range back to front. Filters in the pipeline scan backwards
+// from the end of the source, so taking the last few matches only touches the tail.
+constexpr auto reverse() { return detail::Reverse {}; }
+
+// Lazy merge of two ranges sorted by comp, ties yield the element of a first.
+template <typename RangeA, typename RangeB, typename CompareT = std::less<>>
+constexpr auto merge(RangeA&& a, RangeB&& b, CompareT&& comp = {})
+{
+    return detail::make_set_op<detail::MergeOp>(
+        std::forward<RangeA>(a), std::forward<RangeB>(b), std::forward<CompareT>(comp));
+}
+
+// Lazy intersection of two ranges sorted by comp. Random-access inputs are skipped ahead with
+// exponential search, so a short range intersected with a long one costs O(n log(m/n)).
+template <typename RangeA, typename RangeB, typename CompareT = std::less<>>
+constexpr auto set_intersect(RangeA&& a, RangeB&& b, CompareT&& comp = {})
+{
+    return detail::make_set_op<detail::IntersectOp>(
+        std::forward<RangeA>(a), std::forward<RangeB>(b), std::forward<CompareT>(comp));
+}
+
+// Lazy difference of two ranges sorted by comp, the elements of a not found in b.
+template <typename RangeA, typename RangeB, typename CompareT = std::less<>>
+constexpr auto set_difference(RangeA&& a, RangeB&& b, CompareT&& comp = {})
+{
+    return detail::make_set_op<detail::DifferenceOp>(
+        std::forward<RangeA>(a), std::forward<RangeB>(b), std::forward<CompareT>(comp));
+}
+
+// Terminal collecting the first N elements of a range into a std::array, remaining slots are
+// value initialized. Usable in constant expressions when every stage of the pipeline is.
+template <std::size_t N> constexpr auto to_array() { return detail::ToArray<N> {}; }
+
 template <typename Iterator> struct iterator_range {
 
     using iterator = Iterator;
 
-    iterator_range(Iterator begin, Iterator end)
+    constexpr iterator_range(Iterator begin, Iterator end)
         : _begin { begin }
         , _end { end }
     {
     }
 
-    auto begin() const { return _begin; }
-    auto end() const { return _end; }
+    constexpr auto begin() const { return _begin; }
+    constexpr auto end() const { return _end; }
 
     Iterator _begin;
     Iterator _end;
 };
 
-template <typename Iterator> auto make_iterator_range(Iterator b, Iterator e)
+template <typename Iterator> constexpr auto make_iterator_range(Iterator b, Iterator e)
 {
     return iterator_range<Iterator>(std::move(b), std::move(e));
 }
 
+namespace detail {
+
+template <typename RangeT> struct ReversedRange;
+template <typename RangeT, typename KeyT, template <typename> class IteratorT> struct DistinctRange;
+template <typename RangeT, typename ReducerT> struct SlidingRange;
+template <typename OpT, typename RangeA, typename RangeB, typename CompareT> struct SetOpRange;
+
+namespace meta {
+/*Stages that reorder, drop by history or combine elements have no position on their source, a
+pipeline over them sees them as its source*/
+template <typename T> struct is_opaque_stage : std::false_type {
+};
+template <typename RangeT> struct is_opaque_stage<ReversedRange<RangeT>> : std::true_type {
+};
+template <typename RangeT, typename KeyT, template <typename> class IteratorT>
+struct is_opaque_stage<DistinctRange<RangeT, KeyT, IteratorT>> : std::true_type {
+};
+template <typename RangeT, typename ReducerT>
+struct is_opaque_stage<SlidingRange<RangeT, ReducerT>> : std::true_type {
+};
+template <typename OpT, typename RangeA, typename RangeB, typename CompareT>
+struct is_opaque_stage<SetOpRange<OpT, RangeA, RangeB, CompareT>> : std::true_type {
+};
+
+template <typename PipelineT, typename = void> struct is_materializable : std::false_type {
+};
+template <typename PipelineT>
+struct is_materializable<PipelineT, void_t<decltype(std::declval<PipelineT&>().source())>>
+    : std::integral_constant<bool,
+          !is_opaque_stage<
+              std::decay_t<decltype(std::declval<PipelineT&>().source())>>::value> {
+};
+} // namespace meta
+
+/*Where materialized_view resumes on its source: the last consumed element, as node based
+containers keep their iterators valid on append, or an index for random-access sources*/
+template <typename Iterator,
+    typename Category = typename std::iterator_traits<Iterator>::iterator_category>
+struct ResumePoint {
+    template <typename SourceT> Iterator resume(SourceT& src) const
+    {
+        return consumed_any ? std::next(last) : src.begin();
+    }
+    template <typename SourceT> void consumed(SourceT& src, Iterator from)
+    {
+        for (auto end = src.end(); from != end; ++from) {
+            last         = from;
+            consumed_any = true;
+        }
+    }
+
+private:
+    Iterator last {};
+    bool     consumed_any = false;
+};
+
+template <typename Iterator> struct ResumePoint<Iterator, std::random_access_iterator_tag> {
+    template <typename SourceT> Iterator resume(SourceT& src) const
+    {
+        return src.begin() + count;
+    }
+    template <typename SourceT> void consumed(SourceT& src, Iterator)
+    {
+        count = src.end() - src.begin();
+    }
+
+private:
+    typename std::iterator_traits<Iterator>::difference_type count = 0;
+};
+
+} // namespace detail
+
+// Caches the results of a pipeline over an append-only source. refresh() evaluates the pipeline
+// only on the elements appended to the source since the previous refresh, in O(appended) time.
+// Stages that do not expose their source (distinct, sliding, reverse, set operations) cannot be
+// materialized.
+template <typename PipelineT> struct materialized_view {
+    static_assert(detail::meta::is_materializable<PipelineT>::value,
+        "materialize() requires a pipeline of transform and filter stages over a source");
+
+    using value_type     = std::decay_t<decltype(*std::declval<PipelineT&>().begin())>;
+    using container_type = std::vector<value_type>;
+    using iterator       = typename container_type::const_iterator;
+    using size_type      = typename container_type::size_type;
+
+    explicit materialized_view(PipelineT p)
+        : pipeline { std::move(p) }
+    {
+        refresh();
+    }
+
+    materialized_view& refresh()
+    {
+        auto& src   = pipeline.source();
+        auto  from  = resume_point.resume(src);
+        auto  first = pipeline.iterator_at(from);
+        for (auto last = pipeline.end(); first != last; ++first) {
+            results.push_back(*first);
+        }
+        resume_point.consumed(src, std::move(from));
+        return *this;
+    }
+
+    auto begin() const { return results.begin(); }
+    auto end() const { return results.end(); }
+    auto size() const { return results.size(); }
+    auto empty() const { return results.empty(); }
+    auto data() const { return results.data(); }
+    decltype(auto) operator[](size_type i) const { return results[i]; }
+
+private:
+    using source_iterator = decltype(std::declval<PipelineT&>().source().begin());
+
+    PipelineT                            pipeline;
+    container_type                       results;
+    detail::ResumePoint<source_iterator> resume_point;
+};
+
+template <typename PipelineT> auto materialize(PipelineT&& p)
+{
+    return materialized_view<std::decay_t<PipelineT>>(std::forward<PipelineT>(p));
+}
+
+
+namespace detail {
+
+struct Identity {
+    template <typename T> constexpr T&& operator()(T&& t) const { return std::forward<T>(t); }
+};
+
+struct FirstOf {
+    template <typename P> constexpr const auto& operator()(const P& p) const { return p.first; }
+};
+
+/*Flat open-addressing hash table: entries are stored contiguously in insertion order and an index
+table is probed linearly, so there is no allocation per key.*/
+template <typename KeyT, typename ValueT, typename KeyOfT, typename Hash, typename KeyEqual>
+struct FlatHashTable {
+
+    using key_type       = KeyT;
+    using value_type     = ValueT;
+    using size_type      = std::size_t;
+    using container_type = std::vector<value_type>;
+    using iterator       = typename container_type::iterator;
+    using const_iterator = typename container_type::const_iterator;
+
+    FlatHashTable() = default;
+    explicit FlatHashTable(size_type n, Hash h = Hash(), KeyEqual eq = KeyEqual())
+        : hash { std::move(h) }
+        , equal { std::move(eq) }
+    {
+        reserve(n);
+    }
+
+    auto begin() { return entries.begin(); }
+    auto end() { return entries.end(); }
+    auto begin() const { return entries.begin(); }
+    auto end() const { return entries.end(); }
+    auto size() const { return entries.size(); }
+    auto empty() const { return entries.empty(); }
+
+    void reserve(size_type n)
+    {
+        entries.reserve(n);
+        if (overloaded(n)) {
+            rehash(n);
+        }
+    }
+
+    iterator find(const KeyT& key)
+    {
+        auto slot = probe(key);
+        return slot == npos || slots[slot] == npos ? end() : begin() + slots[slot];
+    }
+    const_iterator find(const KeyT& key) const
+    {
+        auto slot = probe(key);
+        return slot == npos || slots[slot] == npos ? end() : begin() + slots[slot];
+    }
+    size_type count(const KeyT& key) const { return find(key) != end() ? 1 : 0; }
+
+protected:
+    template <typename... Args>
+    std::pair<iterator, bool> emplace_unique(const KeyT& key, Args&&... args)
+    {
+        if (overloaded(entries.size() + 1)) {
+            rehash(entries.size() + 1);
+        }
+        auto slot = probe(key);
+        if (slots[slot] != npos) {
+            return { begin() + slots[slot], false };
+        }
+        // the slot is claimed only once the entry exists, a throwing constructor leaves no trace
+        entries.emplace_back(std::forward<Args>(args)...);
+        slots[slot] = entries.size() - 1;
+        return { std::prev(end()), true };
+    }
+
+private:
+    static constexpr size_type npos = size_type(-1);
+
+    /*keeps the load factor at or below 3/4*/
+    bool overloaded(size_type n) const { return n * 4 > slots.size() * 3; }
+
+    void rehash(size_type n)
+    {
+        size_type capacity = 8;
+        for (shift = 61; capacity * 3 < n * 4; capacity *= 2, --shift)
+            ;
+        slots.assign(capacity, npos);
+        for (size_type i = 0; i < entries.size(); ++i) {
+            slots[probe(KeyOfT {}(entries[i]))] = i;
+        }
+    }
+
+    /*slot holding the key or the empty slot where it belongs, npos if there are no slots*/
+    size_type probe(const KeyT& key) const
+    {
+        if (slots.empty()) {
+            return npos;
+        }
+        const auto mask = slots.size() - 1;
+        // Fibonacci hashing spreads identity hashes such as std::hash<int> over the table
+        auto i = static_cast<size_type>(
+            (std::uint64_t(hash(key)) * 0x9E3779B97F4A7C15ull) >> shift);
+        for (;; i = (i + 1) & mask) {
+            if (slots[i] == npos || equal(KeyOfT {}(entries[slots[i]]), key)) {
+                return i;
+            }
+        }
+    }
+
+    container_type         entries;
+    std::vector<size_type> slots;
+    unsigned               shift = 61;
+    Hash                   hash;
+    KeyEqual               equal;
+};
+
+template <typename KeyT, typename ValueT, typename KeyOfT, typename Hash, typename KeyEqual>
+constexpr typename FlatHashTable<KeyT, ValueT, KeyOfT, Hash, KeyEqual>::size_type
+    FlatHashTable<KeyT, ValueT, KeyOfT, Hash, KeyEqual>::npos;
+
+} // namespace detail
+
+template <typename KeyT, typename MappedT, typename Hash = std::hash<KeyT>,
+    typename KeyEqual = std::equal_to<KeyT>>
+struct flat_hash_map
+    : public detail::FlatHashTable<KeyT, std::pair<KeyT, MappedT>, detail::FirstOf, Hash,
+          KeyEqual> {
+
+    using my_base = detail::FlatHashTable<KeyT, std::pair<KeyT, MappedT>, detail::FirstOf, Hash,
+        KeyEqual>;
+    using mapped_type = MappedT;
+    using iterator    = typename my_base::iterator;
+
+    using my_base::my_base;
+    flat_hash_map() = default;
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const KeyT& key, Args&&... args)
+    {
+        return this->emplace_unique(key, std::piecewise_construct, std::forward_as_tuple(key),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    MappedT& operator[](const KeyT& key) { return try_emplace(key).first->second; }
+};
+
+template <typename KeyT, typename Hash = std::hash<KeyT>, typename KeyEqual = std::equal_to<KeyT>>
+struct flat_hash_set : public detail::FlatHashTable<KeyT, KeyT, detail::Identity, Hash, KeyEqual> {
+
+    using my_base  = detail::FlatHashTable<KeyT, KeyT, detail::Identity, Hash, KeyEqual>;
+    using iterator = typename my_base::iterator;
+
+    using my_base::my_base;
+    flat_hash_set() = default;
+
+    std::pair<iterator, bool> insert(const KeyT& key) { return this->emplace_unique(key, key); }
+};
+
+struct sequential_policy {
+};
+
+struct parallel_policy {
+    unsigned concurrency = 0; // 0 selects std::thread::hardware_concurrency()
+};
+
+constexpr sequential_policy seq {};
+constexpr parallel_policy   par {};
+
+namespace detail {
+
+/*Reducers build their state from the first element with init(), then fold further elements
+with accumulate() and partial states with merge(). Invertible ones can take a merged partial
+state back out with remove().*/
+template <typename ProjectionT> struct SumReducer : private FuncWrapper<ProjectionT> {
+    using FuncWrapper<ProjectionT>::FuncWrapper;
+
+    template <typename T> constexpr auto init(const T& v) const
+    {
+        return std::decay_t<decltype(projection()(v))>(projection()(v));
+    }
+    template <typename R, typename T> constexpr void accumulate(R& r, const T& v) const
+    {
+        r += projection()(v);
+    }
+    template <typename R> constexpr void remove(R& r, const R& other) const { r -= other; }
+    template <typename R> constexpr void merge(R& r, const R& other) const { r += other; }
+
+    constexpr decltype(auto) projection() const
+    {
+        return static_cast<const FuncWrapper<ProjectionT>&>(*this);
+    }
+};
+
+struct CountReducer {
+    template <typename T> constexpr std::size_t init(const T&) const { return 1; }
+    template <typename T> constexpr void        accumulate(std::size_t& r, const T&) const { ++r; }
+    constexpr void merge(std::size_t& r, std::size_t other) const { r += other; }
+    constexpr void remove(std::size_t& r, std::size_t other) const { r -= other; }
+};
+
+template <typename ProjectionT, typename CompareT>
+struct ExtremumReducer : private FuncWrapper<ProjectionT> {
+    using FuncWrapper<ProjectionT>::FuncWrapper;
+
+    template <typename T> constexpr auto init(const T& v) const
+    {
+        return std::decay_t<decltype(projection()(v))>(projection()(v));
+    }
+    template <typename R, typename T> constexpr void accumulate(R& r, const T& v) const
+    {
+        decltype(auto) p = projection()(v);
+        if (CompareT {}(p, r)) {
+            r = p;
+        }
+    }
+    template <typename R> constexpr void merge(R& r, const R& other) const
+    {
+        if (CompareT {}(other, r)) {
+            r = other;
+        }
+    }
+
+    constexpr decltype(auto) projection() const
+    {
+        return static_cast<const FuncWrapper<ProjectionT>&>(*this);
+    }
+};
+
+template <typename PredicateT> struct CollectReducer : private FuncWrapper<PredicateT> {
+    using FuncWrapper<PredicateT>::FuncWrapper;
+
+    template <typename T> auto init(const T& v) const
+    {
+        std::vector<std::decay_t<T>> r;
+        accumulate(r, v);
+        return r;
+    }
+    template <typename R, typename T> void accumulate(R& r, const T& v) const
+    {
+        if (predicate()(v)) {
+            r.push_back(v);
+        }
+    }
+    template <typename R> void merge(R& r, const R& other) const
+    {
+        r.insert(r.end(), other.begin(), other.end());
+    }
+
+    constexpr decltype(auto) predicate() const
+    {
+        return static_cast<const FuncWrapper<PredicateT>&>(*this);
+    }
+};
+
+struct AlwaysTrue {
+    template <typename T> constexpr bool operator()(const T&) const { return true; }
+};
+
+template <typename PolicyT, typename KeyT, typename ReducerT> struct GroupBy {
+    PolicyT           policy;
+    FuncWrapper<KeyT> key;
+    ReducerT          reducer;
+};
+
+template <typename RangeT, typename KeyT, typename ReducerT> struct group_by_traits {
+    using value_type  = decltype(*std::declval<RangeT&>().begin());
+    using key_type    = std::decay_t<decltype(std::declval<const FuncWrapper<KeyT>&>()(
+        std::declval<value_type>()))>;
+    using result_type = decltype(std::declval<const ReducerT&>().init(std::declval<value_type>()));
+    using map_type    = flat_hash_map<key_type, result_type>;
+};
+
+template <typename MapT, typename Iterator, typename KeyT, typename ReducerT>
+void group_into(
+    MapT& groups, Iterator first, Iterator last, const KeyT& key, const ReducerT& reducer)
+{
+    for (; first != last; ++first) {
+        decltype(auto) v     = *first;
+        auto           k     = key(v);
+        auto           found = groups.find(k);
+        if (found != groups.end()) {
+            reducer.accumulate(found->second, v);
+        } else {
+            groups.try_emplace(k, reducer.init(v));
+        }
+    }
+}
+
+/*the size hint bounds the number of keys from above, past this growth is amortized anyway*/
+constexpr std::size_t max_presize = std::size_t(1) << 16;
+
+template <typename RangeT, typename KeyT, typename ReducerT>
+auto operator|(RangeT&& r, GroupBy<sequential_policy, KeyT, ReducerT> g)
+{
+    using map_type = typename group_by_traits<RangeT, KeyT, ReducerT>::map_type;
+    map_type groups(std::min(size_hint(r), max_presize));
+    group_into(groups, r.begin(), r.end(), g.key, g.reducer);
+    return groups;
+}
+
+template <typename F> struct Distinct : public FuncWrapper<F> {
+    using FuncWrapper<F>::FuncWrapper;
+};
+
+template <typename F> struct DistinctSorted : public FuncWrapper<F> {
+    using FuncWrapper<F>::FuncWrapper;
+};
+
+template <typename SequenceT> struct DistinctIterator;
+template <typename SequenceT> struct DistinctSortedIterator;
+
+/*Shared by distinct and distinct_sorted, the two only differ in their iterator*/
+template <typename RangeT, typename KeyT, template <typename> class IteratorT>
+struct DistinctRange : private RangeT, private KeyT {
+
+    using iterator       = IteratorT<DistinctRange>;
+    using const_iterator = IteratorT<const DistinctRange>;
+
+    DistinctRange(RangeT r, KeyT k)
+        : RangeT { std::move(r) }
+        , KeyT { std::move(k) }
+    {
+    }
+
+    auto begin() { return iterator(*this, range().begin()); }
+    auto end() { return iterator(*this, range().end()); }
+    auto begin() const { return const_iterator(*this, range().begin()); }
+    auto end() const { return const_iterator(*this, range().end()); }
+
+    std::size_t    size_hint() const { return range().size_hint(); }
+    decltype(auto) key() const { return static_cast<const KeyT&>(*this); }
+    decltype(auto) range() { return static_cast<RangeT&>(*this); }
+    decltype(auto) range() const { return static_cast<const RangeT&>(*this); }
+};
+
+template <typename SequenceT> struct DistinctIteratorBase {
+
+    using iterator          = meta::iterator_t<decltype(std::declval<SequenceT&>().range())>;
+    using traits            = std::iterator_traits<iterator>;
+    using value_type        = typename traits::value_type;
+    using difference_type   = typename traits::difference_type;
+    using reference         = typename traits::reference;
+    using pointer           = typename traits::pointer;
+    using key_type          = std::decay_t<decltype(
+        std::declval<SequenceT&>().key()(std::declval<reference>()))>;
+
+    DistinctIteratorBase(SequenceT& _seq, iterator _it)
+        : seq { &_seq }
+        , it { std::move(_it) }
+    {
+    }
+
+    decltype(auto) operator*() const { return *it; }
+    bool           operator==(const DistinctIteratorBase& rhs) const { return it == rhs.it; }
+    bool           operator!=(const DistinctIteratorBase& rhs) const { return !((*this) == rhs); }
+
+    SequenceT* seq;
+    iterator   it;
+};
+
+/*Remembers the keys seen so far in a flat_hash_set owned by the traversal. Copies of an
+iterator share that set, hence distinct() only provides single-pass iteration.*/
+template <typename SequenceT> struct DistinctIterator : public DistinctIteratorBase<SequenceT> {
+
+    using my_base           = DistinctIteratorBase<SequenceT>;
+    using iterator_category = std::input_iterator_tag;
+    using seen_t            = flat_hash_set<typename my_base::key_type>;
+
+    DistinctIterator(SequenceT& _seq, typename my_base::iterator _it)
+        : my_base { _seq, std::move(_it) }
+    {
+        if (this->it != this->seq->range().end()) {
+            seen = std::make_shared<seen_t>(std::min(this->seq->size_hint(), max_presize));
+            next();
+        }
+    }
+
+    DistinctIterator& operator++()
+    {
+        ++this->it;
+        next();
+        return *this;
+    }
+    auto operator++(int) { return post_increment(*this, std::true_type {}); }
+
+private:
+    void next()
+    {
+        for (auto last = this->seq->range().end();
+             this->it != last && !seen->insert(this->seq->key()(*this->it)).second; ++this->it)
+            ;
+    }
+
+    std::shared_ptr<seen_t> seen;
+};
+
+/*Equal keys are adjacent in sorted input, so only the key of the current element is kept*/
+template <typename SequenceT>
+struct DistinctSortedIterator : public DistinctIteratorBase<SequenceT> {
+
+    using my_base           = DistinctIteratorBase<SequenceT>;
+    using iterator_category = meta::iterator_min_t<typename my_base::traits::iterator_category,
+        std::forward_iterator_tag>;
+
+    using my_base::my_base;
+
+    DistinctSortedIterator& operator++()
+    {
+        auto current = this->seq->key()(*this->it);
+        for (auto last = this->seq->range().end();
+             ++this->it != last && this->seq->key()(*this->it) == current;)
+            ;
+        return *this;
+    }
+    auto operator++(int)
+    {
+        return post_increment(*this, meta::is_single_pass<DistinctSortedIterator> {});
+    }
+};
+
+template <typename RangeT, typename F> auto operator|(RangeT&& r, Distinct<F> d)
+{
+    using range = Range<RangeT>;
+    return DistinctRange<range, Distinct<F>, DistinctIterator>(
+        range(std::forward<RangeT>(r)), std::move(d));
+}
+
+template <typename RangeT, typename F> auto operator|(RangeT&& r, DistinctSorted<F> d)
+{
+    using range = Range<RangeT>;
+    return DistinctRange<range, DistinctSorted<F>, DistinctSortedIterator>(
+        range(std::forward<RangeT>(r)), std::move(d));
+}
+
+template <typename PolicyT, typename CompareT> struct TopK {
+    PolicyT               policy;
+    std::size_t           k;
+    FuncWrapper<CompareT> comp;
+};
+
+/*Keeps the k best elements in a heap whose top is the worst of them, so memory stays
+O(min(k, n)). Only a known size hint bounds the reservation, a generous k must not allocate.*/
+template <typename HeapT, typename Iterator, typename CompareT>
+void top_k_into(HeapT& heap, Iterator first, Iterator last, std::size_t k, const CompareT& comp)
+{
+    for (; k > 0 && first != last; ++first) {
+        decltype(auto) v = *first;
+        if (heap.size() < k) {
+            heap.push_back(v);
+            std::push_heap(heap.begin(), heap.end(), comp);
+        } else if (comp(v, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), comp);
+            heap.back() = v;
+            std::push_heap(heap.begin(), heap.end(), comp);
+        }
+    }
+}
+
+template <typename Iterator, typename CompareT>
+auto top_k_of(Iterator first, Iterator last, std::size_t k, const CompareT& comp, std::size_t hint)
+{
+    std::vector<std::decay_t<decltype(*first)>> heap;
+    heap.reserve(std::min(k, hint));
+    top_k_into(heap, first, last, k, comp);
+    std::sort_heap(heap.begin(), heap.end(), comp);
+    return heap;
+}
+
+template <typename RangeT, typename CompareT>
+auto operator|(RangeT&& r, TopK<sequential_policy, CompareT> t)
+{
+    return top_k_of(r.begin(), r.end(), t.k, t.comp, size_hint(r));
+}
+
+template <typename... ReducerTs> struct FanOut {
+    std::tuple<ReducerTs...> reducers;
+};
+
+template <typename RangeT, typename... ReducerTs, std::size_t... Is>
+auto fan_out_impl(RangeT&& r, const std::tuple<ReducerTs...>& reducers, std::index_sequence<Is...>)
+{
+    using value_type = decltype(*r.begin());
+    std::tuple<std::decay_t<decltype(
+        std::get<Is>(reducers).init(std::declval<value_type>()))>...>
+        results {};
+
+    auto first = r.begin();
+    auto last  = r.end();
+    if (first == last) {
+        return results;
+    }
+    {
+        decltype(auto) v = *first;
+        results          = std::make_tuple(std::get<Is>(reducers).init(v)...);
+    }
+    for (++first; first != last; ++first) {
+        decltype(auto) v = *first;
+        (void)std::initializer_list<int> {
+            (std::get<Is>(reducers).accumulate(std::get<Is>(results), v), 0)...
+        };
+    }
+    return results;
+}
+
+template <typename RangeT, typename... ReducerTs>
+auto operator|(RangeT&& r, const FanOut<ReducerTs...>& f)
+{
+    return fan_out_impl(
+        std::forward<RangeT>(r), f.reducers, std::index_sequence_for<ReducerTs...> {});
+}
+
+/*One queue of chunks per worker. The owner takes its newest chunk from the back, idle workers
+steal the oldest chunk of another queue from the front and sleep while every queue is empty*/
+template <typename Iterator> struct ChunkQueues {
+    using chunk = std::pair<Iterator, Iterator>;
+
+    explicit ChunkQueues(std::size_t workers)
+        : queues(workers)
+    {
+    }
+
+    void push(std::size_t worker, chunk c)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queues[worker].mutex);
+            queues[worker].chunks.push_back(std::move(c));
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++queued;
+        }
+        ready.notify_one();
+    }
+
+    /*takes a chunk, its own or a stolen one, and runs f(worker, first, last) on it outside of
+    the locks, returns false when every queue was empty*/
+    template <typename F> bool run_one(std::size_t worker, F& f)
+    {
+        std::vector<chunk> taken; // pipeline iterators are not default constructible
+        {
+            std::lock_guard<std::mutex> lock(queues[worker].mutex);
+            auto&                       own = queues[worker].chunks;
+            if (!own.empty()) {
+                taken.push_back(std::move(own.back()));
+                own.pop_back();
+            }
+        }
+        for (std::size_t i = 1; taken.empty() && i < queues.size(); ++i) {
+            auto&                       victim = queues[(worker + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.chunks.empty()) {
+                taken.push_back(std::move(victim.chunks.front()));
+                victim.chunks.pop_front();
+            }
+        }
+        if (taken.empty()) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --queued;
+        }
+        f(worker, std::move(taken.front().first), std::move(taken.front().second));
+        return true;
+    }
+
+    /*blocks until a chunk is queued or the producer is done, returns false in the latter case
+    when no chunk is left*/
+    bool wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return queued > 0 || !producing; });
+        return queued > 0;
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            producing = false;
+        }
+        ready.notify_all();
+    }
+
+private:
+    struct Queue {
+        std::mutex        mutex;
+        std::deque<chunk> chunks;
+    };
+
+    std::vector<Queue>      queues;
+    std::mutex              mutex;
+    std::condition_variable ready;
+    std::size_t             queued    = 0;
+    bool                    producing = true;
+};
+
+inline std::size_t worker_count(const parallel_policy& policy)
+{
+    return std::max<std::size_t>(
+        1, policy.concurrency ? policy.concurrency : std::thread::hardware_concurrency());
+}
+
+/*the first chunks are small so that every worker gets busy early, later ones grow geometrically
+up to a share of the size hint to keep the scheduling overhead low*/
+constexpr std::size_t max_chunk = 1024;
+
+/*Cuts a forward range into chunks on the calling thread and runs f(worker, first, last) on them
+through a work-stealing scheduler. The calling thread joins the workers once the range is cut.*/
+template <typename Iterator, typename F>
+void work_stealing(const parallel_policy& policy, Iterator first, Iterator last,
+    std::size_t hint, F f)
+{
+    static_assert(std::is_base_of<std::forward_iterator_tag,
+                      typename std::iterator_traits<Iterator>::iterator_category>::value,
+        "chunks of a single-pass range cannot be handed to other threads");
+
+    const auto threads = worker_count(policy);
+    const auto largest
+        = hint ? std::max<std::size_t>(1, std::min(hint / (threads * 4), max_chunk)) : max_chunk;
+
+    ChunkQueues<Iterator> queues(threads);
+    auto                  work = [&](std::size_t worker) {
+        while (queues.run_one(worker, f) || queues.wait())
+            ;
+    };
+
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(threads - 1);
+    for (std::size_t worker = 1; worker < threads; ++worker) {
+        tasks.push_back(std::async(std::launch::async, work, worker));
+    }
+    try {
+        for (std::size_t n = 0, size = 1; first != last; ++n, size = std::min(size * 2, largest)) {
+            auto chunk_first = first;
+            for (std::size_t i = 0; i < size && first != last; ++i) {
+                ++first;
+            }
+            queues.push(n % threads, { chunk_first, first });
+        }
+    } catch (...) {
+        queues.close();
+        throw;
+    }
+    queues.close();
+    work(0);
+    for (auto& task : tasks) {
+        task.get();
+    }
+}
+
+/*Pipelines exposing their source are cut on the source iterators, every worker then evaluates a
+copy of the whole pipeline over its slice so that each stage runs once per element, on the
+workers only. Other ranges are cut on their own iterators.*/
+template <typename RangeT, typename F>
+void parallel_slices(const parallel_policy& policy, RangeT& r, F f, std::true_type)
+{
+    auto& src = r.source();
+    work_stealing(policy, src.begin(), src.end(), size_hint(src),
+        [&](std::size_t worker, auto first, auto last) {
+            f(worker, r.rebased(std::move(first), std::move(last)));
+        });
+}
+template <typename RangeT, typename F>
+void parallel_slices(const parallel_policy& policy, RangeT& r, F f, std::false_type)
+{
+    work_stealing(policy, r.begin(), r.end(), size_hint(r),
+        [&](std::size_t worker, auto first, auto last) {
+            f(worker, make_iterator_range(std::move(first), std::move(last)));
+        });
+}
+template <typename RangeT, typename F>
+void parallel_slices(const parallel_policy& policy, RangeT& r, F f)
+{
+    parallel_slices(policy, r, std::move(f), meta::has_source<RangeT> {});
+}
+
+template <typename PolicyT, typename F> struct ForEach {
+    PolicyT        policy;
+    FuncWrapper<F> f;
+};
+
+template <typename RangeT, typename F> void operator|(RangeT&& r, ForEach<sequential_policy, F> e)
+{
+    for (auto first = r.begin(), last = r.end(); first != last; ++first) {
+        e.f(*first);
+    }
+}
+
+template <typename RangeT, typename F>
+void operator|(RangeT&& r, const ForEach<parallel_policy, F>& e)
+{
+    parallel_slices(e.policy, r, [&](std::size_t, auto&& slice) {
+        for (auto first = slice.begin(), last = slice.end(); first != last; ++first) {
+            e.f(*first);
+        }
+    });
+}
+
+template <typename PolicyT, typename T, typename OpT> struct Reduce {
+    PolicyT          policy;
+    T                init;
+    FuncWrapper<OpT> op;
+};
+
+template <typename RangeT, typename T, typename OpT>
+T operator|(RangeT&& r, Reduce<sequential_policy, T, OpT> rd)
+{
+    for (auto first = r.begin(), last = r.end(); first != last; ++first) {
+        rd.init = rd.op(std::move(rd.init), *first);
+    }
+    return std::move(rd.init);
+}
+
+template <typename RangeT, typename T, typename OpT>
+T operator|(RangeT&& r, Reduce<parallel_policy, T, OpT> rd)
+{
+    // at most one partial result per worker, empty until the worker met its first element
+    std::vector<std::vector<T>> partials(worker_count(rd.policy));
+    parallel_slices(rd.policy, r, [&](std::size_t worker, auto&& slice) {
+        auto& partial = partials[worker];
+        for (auto first = slice.begin(), last = slice.end(); first != last; ++first) {
+            if (partial.empty()) {
+                partial.emplace_back(*first);
+            } else {
+                partial.front() = rd.op(std::move(partial.front()), *first);
+            }
+        }
+    });
+    for (auto& partial : partials) {
+        if (!partial.empty()) {
+            rd.init = rd.op(std::move(rd.init), std::move(partial.front()));
+        }
+    }
+    return std::move(rd.init);
+}
+
+template <typename RangeT, typename KeyT, typename ReducerT>
+auto operator|(RangeT&& r, GroupBy<parallel_policy, KeyT, ReducerT> g)
+{
+    using map_type = typename group_by_traits<RangeT, KeyT, ReducerT>::map_type;
+
+    // one table per worker, created on its first chunk and pre-sized for its share of the range
+    const auto workers = worker_count(g.policy);
+    const auto presize = std::min(size_hint(r) / workers, max_presize);
+
+    std::vector<std::vector<map_type>> partials(workers);
+    parallel_slices(g.policy, r, [&](std::size_t worker, auto&& slice) {
+        auto& partial = partials[worker];
+        if (partial.empty()) {
+            partial.emplace_back(presize);
+        }
+        group_into(partial.front(), slice.begin(), slice.end(), g.key, g.reducer);
+    });
+
+    map_type groups;
+    bool     merged = false;
+    for (auto& partial : partials) {
+        if (partial.empty()) {
+            continue;
+        }
+        if (!std::exchange(merged, true)) {
+            groups = std::move(partial.front());
+            continue;
+        }
+        for (auto& entry : partial.front()) {
+            auto inserted = groups.try_emplace(entry.first, std::move(entry.second));
+            if (!inserted.second) {
+                g.reducer.merge(inserted.first->second, entry.second);
+            }
+        }
+    }
+    return groups;
+}
+
+template <typename RangeT, typename CompareT>
+auto operator|(RangeT&& r, TopK<parallel_policy, CompareT> t)
+{
+    using value_type = std::decay_t<decltype(*r.begin())>;
+
+    // one heap per worker, fed by every slice it runs
+    std::vector<std::vector<value_type>> heaps(worker_count(t.policy));
+    parallel_slices(t.policy, r, [&](std::size_t worker, auto&& slice) {
+        top_k_into(heaps[worker], slice.begin(), slice.end(), t.k, t.comp);
+    });
+
+    std::vector<value_type> candidates;
+    std::size_t             n = 0;
+    for (auto& heap : heaps) {
+        n += heap.size();
+    }
+    candidates.reserve(n);
+    for (auto& heap : heaps) {
+        std::move(heap.begin(), heap.end(), std::back_inserter(candidates));
+    }
+    return top_k_of(std::make_move_iterator(candidates.begin()),
+        std::make_move_iterator(candidates.end()), t.k, t.comp, n);
+}
+
+template <typename ReducerT> struct Sliding {
+    std::size_t w;
+    ReducerT    reducer;
+};
+
+template <typename SequenceT> struct SlidingIterator;
+
+template <typename RangeT, typename ReducerT> struct SlidingRange : private RangeT {
+
+    using iterator       = SlidingIterator<SlidingRange>;
+    using const_iterator = SlidingIterator<const SlidingRange>;
+
+    SlidingRange(RangeT r, Sliding<ReducerT> s)
+        : RangeT { std::move(r) }
+        , sliding { std::move(s) }
+    {
+    }
+
+    auto begin() { return iterator(*this, range().begin(), true); }
+    auto end() { return iterator(*this, range().end(), false); }
+    auto begin() const { return const_iterator(*this, range().begin(), true); }
+    auto end() const { return const_iterator(*this, range().end(), false); }
+
+    std::size_t    size_hint() const { return range().size_hint(); }
+    std::size_t    window() const { return sliding.w; }
+    decltype(auto) reducer() const { return static_cast<const ReducerT&>(sliding.reducer); }
+    decltype(auto) range() { return static_cast<RangeT&>(*this); }
+    decltype(auto) range() const { return static_cast<const RangeT&>(*this); }
+
+private:
+    Sliding<ReducerT> sliding;
+};
+
+/*Keeps the state of the window ending at head, every element of the window is dereferenced and
+passed to init() once. Invertible reducers over integral states keep a running total and remove
+the state of the element leaving the window, floating-point totals would lose the small values
+to cancellation. Others keep two stacks of states: back folds the elements entering the window,
+front holds the suffix states of older elements and is rebuilt from back when emptied, so every
+element is merged O(1) times. Random-access iterators step back over invertible windows in O(1)
+per element, other jumps rebuild the window in O(w).*/
+template <typename SequenceT> struct SlidingIterator {
+
+    using iterator     = meta::iterator_t<decltype(std::declval<SequenceT&>().range())>;
+    using traits       = std::iterator_traits<iterator>;
+    using reducer_type = std::decay_t<decltype(std::declval<SequenceT&>().reducer())>;
+    using state_type   = std::decay_t<decltype(
+        std::declval<const reducer_type&>().init(std::declval<typename traits::reference>()))>;
+    using invertible   = std::integral_constant<bool,
+        meta::has_remove<reducer_type, state_type>::value && std::is_integral<state_type>::value>;
+
+    static_assert(std::is_base_of<std::forward_iterator_tag,
+                      typename traits::iterator_category>::value,
+        "sliding windows revisit elements and require forward iterators");
+
+    using iterator_category = std::conditional_t<std::is_same<typename traits::iterator_category,
+                                                     std::random_access_iterator_tag>::value,
+        std::random_access_iterator_tag, std::forward_iterator_tag>;
+    using difference_type   = typename traits::difference_type;
+    using value_type        = state_type;
+    using reference         = state_type;
+    using pointer           = void;
+
+    SlidingIterator(SequenceT& _seq, iterator _it, bool first)
+        : seq { &_seq }
+        , head { _it }
+    {
+        if (first) {
+            fill(std::move(_it));
+        }
+    }
+
+    state_type operator*() const { return aggregate(invertible {}); }
+
+    SlidingIterator& operator++()
+    {
+        if (++head != seq->range().end()) {
+            push(*head, invertible {});
+            pop(invertible {});
+        }
+        return *this;
+    }
+    SlidingIterator operator++(int)
+    {
+        auto temp = *this;
+        ++(*this);
+        return temp;
+    }
+
+    bool operator==(const SlidingIterator& rhs) const { return head == rhs.head; }
+    bool operator!=(const SlidingIterator& rhs) const { return !((*this) == rhs); }
+
+    /*Random-access API*/
+    SlidingIterator& operator+=(difference_type n)
+    {
+        const auto w = static_cast<difference_type>(seq->window());
+        if (n > 0 && n < w) {
+            for (; n > 0; --n) {
+                ++(*this);
+            }
+        } else if (n < 0 && -n < w && head != seq->range().end()) {
+            retreat(-n, invertible {});
+        } else if (n != 0) {
+            jump(n);
+        }
+        return *this;
+    }
+    SlidingIterator& operator-=(difference_type n) { return (*this) += -n; }
+    SlidingIterator& operator--() { return (*this) -= 1; }
+    SlidingIterator  operator--(int)
+    {
+        auto temp = *this;
+        --(*this);
+        return temp;
+    }
+    SlidingIterator operator+(difference_type n) const
+    {
+        auto temp = *this;
+        return temp += n;
+    }
+    SlidingIterator operator-(difference_type n) const
+    {
+        auto temp = *this;
+        return temp -= n;
+    }
+    difference_type operator-(const SlidingIterator& rhs) const { return head - rhs.head; }
+    state_type      operator[](difference_type n) const { return *((*this) + n); }
+    bool            operator<(const SlidingIterator& rhs) const { return head < rhs.head; }
+    bool            operator<=(const SlidingIterator& rhs) const { return head <= rhs.head; }
+    bool            operator>(const SlidingIterator& rhs) const { return head > rhs.head; }
+    bool            operator>=(const SlidingIterator& rhs) const { return head >= rhs.head; }
+
+private:
+    /*positions head on the w-th element from first, or on the end of the range when there are
+    fewer elements left*/
+    void fill(iterator first)
+    {
+        head = std::move(first);
+        total.clear();
+        front.clear();
+        back.clear();
+        const auto w    = seq->window();
+        const auto last = seq->range().end();
+        for (std::size_t i = 0; w > 0 && head != last; ++head) {
+            push(*head, invertible {});
+            if (++i == w) {
+                return;
+            }
+        }
+        head = last;
+    }
+
+    template <typename V> void push(V&& v, std::true_type)
+    {
+        back.push_back(reducer().init(v));
+        if (total.empty()) {
+            total.push_back(back.back());
+        } else {
+            reducer().merge(total.front(), back.back());
+        }
+    }
+    void pop(std::true_type)
+    {
+        reducer().remove(total.front(), back.front());
+        back.pop_front();
+    }
+    state_type aggregate(std::true_type) const { return total.front(); }
+
+    /*the element before the window enters at the front and the head leaves at the back*/
+    void retreat(difference_type n, std::true_type)
+    {
+        const auto w = static_cast<difference_type>(seq->window());
+        for (; n > 0; --n, --head) {
+            decltype(auto) entering = *(head - w);
+            back.push_front(reducer().init(entering));
+            reducer().merge(total.front(), back.front());
+            reducer().remove(total.front(), back.back());
+            back.pop_back();
+        }
+    }
+    void retreat(difference_type n, std::false_type) { jump(-n); }
+
+    void jump(difference_type n)
+    {
+        const auto w = static_cast<difference_type>(seq->window());
+        head += n;
+        if (head != seq->range().end()) {
+            fill(head - (w - 1));
+        }
+    }
+
+    template <typename V> void push(V&& v, std::false_type)
+    {
+        back.push_back(reducer().init(v));
+        if (back.size() == 1) {
+            total.clear();
+            total.push_back(back.back());
+        } else {
+            reducer().merge(total.front(), back.back());
+        }
+    }
+    void pop(std::false_type)
+    {
+        if (front.empty()) {
+            // the newest element ends up at the bottom, the oldest one on top
+            for (auto state = back.rbegin(); state != back.rend(); ++state) {
+                if (!front.empty()) {
+                    reducer().merge(*state, front.back());
+                }
+                front.push_back(std::move(*state));
+            }
+            back.clear();
+            total.clear();
+        }
+        front.pop_back();
+    }
+    state_type aggregate(std::false_type) const
+    {
+        if (front.empty()) {
+            return total.front();
+        }
+        auto state = front.back();
+        if (!back.empty()) {
+            reducer().merge(state, total.front());
+        }
+        return state;
+    }
+
+    decltype(auto) reducer() const { return seq->reducer(); }
+
+    SequenceT* seq;
+    iterator   head;
+    // at most one element, the state of the whole window or of back when there are two stacks
+    std::vector<state_type> total;
+    std::vector<state_type> front;
+    // states of the elements of the window, or of the newer ones when there are two stacks
+    std::deque<state_type> back;
+};
+
+template <typename RangeT, typename ReducerT> auto operator|(RangeT&& r, Sliding<ReducerT> s)
+{
+    using range = Range<RangeT>;
+    return SlidingRange<range, ReducerT>(range(std::forward<RangeT>(r)), std::move(s));
+}
+
+} // namespace detail
+
+inline auto count() { return detail::CountReducer {}; }
+
+inline auto sum() { return detail::SumReducer<detail::Identity> {}; }
+
+template <typename ProjectionT> auto sum(ProjectionT&& p)
+{
+    return detail::SumReducer<std::remove_reference_t<ProjectionT>>(std::forward<ProjectionT>(p));
+}
+
+inline auto min() { return detail::ExtremumReducer<detail::Identity, std::less<>> {}; }
+
+template <typename ProjectionT> auto min(ProjectionT&& p)
+{
+    return detail::ExtremumReducer<std::remove_reference_t<ProjectionT>, std::less<>>(
+        std::forward<ProjectionT>(p));
+}
+
+inline auto max() { return detail::ExtremumReducer<detail::Identity, std::greater<>> {}; }
+
+template <typename ProjectionT> auto max(ProjectionT&& p)
+{
+    return detail::ExtremumReducer<std::remove_reference_t<ProjectionT>, std::greater<>>(
+        std::forward<ProjectionT>(p));
+}
+
+inline auto collect() { return detail::CollectReducer<detail::AlwaysTrue> {}; }
+
+template <typename PredicateT> auto collect_if(PredicateT&& p)
+{
+    return detail::CollectReducer<std::remove_reference_t<PredicateT>>(std::forward<PredicateT>(p));
+}
+
+// Terminal grouping the elements of a range by key_fn and folding every group with reducer,
+// returns a flat_hash_map from key to the reduced value.
+template <typename KeyT, typename ReducerT> auto group_by(KeyT&& key_fn, ReducerT reducer)
+{
+    using key = std::remove_reference_t<KeyT>;
+    return detail::GroupBy<sequential_policy, key, ReducerT> { seq,
+        detail::FuncWrapper<key>(std::forward<KeyT>(key_fn)), std::move(reducer) };
+}
+
+// Builds one partial table per worker over chunks of a forward range handed out by the scheduler
+// of for_each(par, f) and merges them, key_fn and reducer must be safe to call concurrently.
+template <typename KeyT, typename ReducerT>
+auto group_by(parallel_policy policy, KeyT&& key_fn, ReducerT reducer)
+{
+    using key = std::remove_reference_t<KeyT>;
+    return detail::GroupBy<parallel_policy, key, ReducerT> { policy,
+        detail::FuncWrapper<key>(std::forward<KeyT>(key_fn)), std::move(reducer) };
+}
+
+// Terminal evaluating a range once and feeding every element to each reducer, returns a tuple
+// of the results. Reducers that saw no element yield a value initialized result.
+template <typename... ReducerTs> auto fan_out(ReducerTs... reducers)
+{
+    static_assert(sizeof...(ReducerTs) > 0, "fan_out needs at least one reducer");
+    return detail::FanOut<ReducerTs...> { std::make_tuple(std::move(reducers)...) };
+}
+
+// Stage dropping elements whose key_fn was already seen, keys are kept in a flat_hash_set
+// pre-sized from the size hint of the range. Single-pass.
+inline auto distinct() { return detail::Distinct<detail::Identity> {}; }
+
+template <typename KeyT> auto distinct(KeyT&& key_fn)
+{
+    return detail::Distinct<std::remove_reference_t<KeyT>>(std::forward<KeyT>(key_fn));
+}
+
+// Stage dropping consecutive elements with equal key_fn, deduplicates input sorted by that key
+// with O(1) memory.
+inline auto distinct_sorted() { return detail::DistinctSorted<detail::Identity> {}; }
+
+template <typename KeyT> auto distinct_sorted(KeyT&& key_fn)
+{
+    return detail::DistinctSorted<std::remove_reference_t<KeyT>>(std::forward<KeyT>(key_fn));
+}
+
+// Stage yielding the state of reducer over each window of w consecutive elements of a forward
+// range, n elements give n - w + 1 windows. Invertible reducers such as sum() and count() update
+// in O(1) per step, others such as min() and max() in amortized O(1) merges. Random-access
+// sources keep random access.
+template <typename ReducerT> auto sliding(std::size_t w, ReducerT reducer)
+{
+    return detail::Sliding<ReducerT> { w, std::move(reducer) };
+}
+
+// Terminal returning the k first elements of a range in comp order (the k largest by default)
+// sorted best first, without materializing the range.
+template <typename CompareT = std::greater<>> auto top_k(std::size_t k, CompareT&& comp = {})
+{
+    using compare = std::remove_reference_t<CompareT>;
+    return detail::TopK<sequential_policy, compare> { seq, k,
+        detail::FuncWrapper<compare>(std::forward<CompareT>(comp)) };
+}
+
+// Selects the top k of every slice of a range on the worker threads and merges them.
+template <typename CompareT = std::greater<>>
+auto top_k(parallel_policy policy, std::size_t k, CompareT&& comp = {})
+{
+    using compare = std::remove_reference_t<CompareT>;
+    return detail::TopK<parallel_policy, compare> { policy, k,
+        detail::FuncWrapper<compare>(std::forward<CompareT>(comp)) };
+}
+
+// Terminal calling f on every element of a range, in order.
+template <typename F> auto for_each(F&& f)
+{
+    using func = std::remove_reference_t<F>;
+    return detail::ForEach<sequential_policy, func> { seq,
+        detail::FuncWrapper<func>(std::forward<F>(f)) };
+}
+
+// Calls f on every element of a forward range from several threads. The source of the pipeline is
+// cut into chunks of growing size handed out through a work-stealing scheduler, so ranges without
+// random access and elements of uneven cost still keep every worker busy. All stages run on the
+// workers, once per element. f must be safe to call concurrently.
+template <typename F> auto for_each(parallel_policy policy, F&& f)
+{
+    using func = std::remove_reference_t<F>;
+    return detail::ForEach<parallel_policy, func> { policy,
+        detail::FuncWrapper<func>(std::forward<F>(f)) };
+}
+
+// Terminal folding the elements of a range into init with op, left to right.
+template <typename T, typename OpT> auto reduce(T init, OpT&& op)
+{
+    using binary = std::remove_reference_t<OpT>;
+    return detail::Reduce<sequential_policy, T, binary> { seq, std::move(init),
+        detail::FuncWrapper<binary>(std::forward<OpT>(op)) };
+}
+
+// Folds a forward range on several threads with the scheduler of for_each(par, f). Elements are
+// combined in an unspecified order and grouping, so op must be associative and commutative.
+template <typename T, typename OpT> auto reduce(parallel_policy policy, T init, OpT&& op)
+{
+    using binary = std::remove_reference_t<OpT>;
+    return detail::Reduce<parallel_policy, T, binary> { policy, std::move(init),
+        detail::FuncWrapper<binary>(std::forward<OpT>(op)) };
+}
+
+// Source adaptor moving r into a reference counted block, so that copying a pipeline built on it
+// costs O(1) whatever the size of r. An lvalue r is copied once.
+template <typename RangeT> auto share(RangeT&& r)
+{
+    using range = std::decay_t<RangeT>;
+    return detail::SharedRange<range>(std::make_shared<range>(std::forward<RangeT>(r)));
+}
+
+// Source adaptor referring to r, which has to outlive every pipeline built on the result. This is
+// what piping an lvalue does implicitly.
+template <typename RangeT> constexpr auto borrow(RangeT& r) { return detail::Range<RangeT&>(r); }
+template <typename RangeT> void borrow(const RangeT&&) = delete;
+
+// How a pipeline holds its elements: owned ones are copied along with the pipeline, shared and
+// borrowed ones are not.
+enum class ownership { owned, shared, borrowed };
+
+namespace detail {
+constexpr ownership combine(ownership a, ownership b)
+{
+    return a == ownership::owned || b == ownership::owned
+        ? ownership::owned
+        : (a == ownership::shared || b == ownership::shared ? ownership::shared
+                                                            : ownership::borrowed);
+}
+} // namespace detail
+
+// Ownership mode of a pipeline, found by walking its stages down to the first source that is not
+// stored by value. Containers and other ranges not built by lranges are owned.
+template <typename PipelineT>
+struct ownership_of : std::integral_constant<ownership, ownership::owned> {
+};
+
+template <typename PipelineT> struct ownership_of<const PipelineT> : ownership_of<PipelineT> {
+};
+
+template <typename Iterator>
+struct ownership_of<iterator_range<Iterator>>
+    : std::integral_constant<ownership, ownership::borrowed> {
+};
+
+template <typename RangeT>
+struct ownership_of<detail::Range<RangeT&>>
+    : std::integral_constant<ownership, ownership::borrowed> {
+};
+
+template <typename RangeT> struct ownership_of<detail::Range<RangeT>> : ownership_of<RangeT> {
+};
+
+template <typename RangeT>
+struct ownership_of<detail::SharedRange<RangeT>>
+    : std::integral_constant<ownership, ownership::shared> {
+};
+
+template <typename RangeT, typename TransformationT>
+struct ownership_of<detail::TransformedRange<RangeT, TransformationT>> : ownership_of<RangeT> {
+};
+
+template <typename RangeT, typename FilterPredicate>
+struct ownership_of<detail::FilteredRange<RangeT, FilterPredicate>> : ownership_of<RangeT> {
+};
+
+template <typename RangeT>
+struct ownership_of<detail::ReversedRange<RangeT>> : ownership_of<RangeT> {
+};
+
+template <typename RangeT, typename KeyT, template <typename> class IteratorT>
+struct ownership_of<detail::DistinctRange<RangeT, KeyT, IteratorT>> : ownership_of<RangeT> {
+};
+
+template <typename RangeT, typename ReducerT>
+struct ownership_of<detail::SlidingRange<RangeT, ReducerT>> : ownership_of<RangeT> {
+};
+
+template <typename OpT, typename RangeA, typename RangeB, typename CompareT>
+struct ownership_of<detail::SetOpRange<OpT, RangeA, RangeB, CompareT>>
+    : std::integral_constant<ownership,
+          detail::combine(ownership_of<RangeA>::value, ownership_of<RangeB>::value)> {
+};
+
+#if defined(LRANGES_HAS_COROUTINES)
+
+namespace detail {
+
+/*Recycles coroutine frames through per-thread free lists bucketed by size, so a producer that
+keeps creating generators stops hitting the heap once the lists are warm*/
+struct FrameAllocator {
+
+    static void* allocate(std::size_t n)
+    {
+        auto b = bucket(n);
+        if (torn_down()) {
+            return ::operator new(n);
+        }
+        auto& lists = cache();
+        if (b < buckets && lists.heads[b]) {
+            auto block     = lists.heads[b];
+            lists.heads[b] = block->next;
+            --lists.counts[b];
+            return block;
+        }
+        return ::operator new(b < buckets ? (b + 1) * granularity : n);
+    }
+
+    static void deallocate(void* p, std::size_t n) noexcept
+    {
+        auto b = bucket(n);
+        if (torn_down()) {
+            ::operator delete(p);
+            return;
+        }
+        auto& lists = cache();
+        if (b < buckets && lists.counts[b] < max_cached) {
+            lists.heads[b] = new (p) FreeBlock { lists.heads[b] };
+            ++lists.counts[b];
+            return;
+        }
+        ::operator delete(p);
+    }
+
+private:
+    static constexpr std::size_t granularity = 64;
+    static constexpr std::size_t buckets     = 32;
+    static constexpr std::size_t max_cached  = 16;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct FreeLists {
+        FreeBlock*  heads[buckets] {};
+        std::size_t counts[buckets] {};
+
+        ~FreeLists()
+        {
+            torn_down() = true;
+            for (auto head : heads) {
+                while (head) {
+                    ::operator delete(std::exchange(head, head->next));
+                }
+            }
+        }
+    };
+
+    /*frames released after the lists of their thread are destroyed, for instance by static
+    generators at exit, bypass the lists. The flag is trivially destructible and outlives them.*/
+    static bool& torn_down()
+    {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+    static std::size_t bucket(std::size_t n) { return (n + granularity - 1) / granularity - 1; }
+
+    static FreeLists& cache()
+    {
+        thread_local FreeLists lists;
+        return lists;
+    }
+};
+
+} // namespace detail
+
+// Single-pass range over the values a coroutine co_yields, resumed lazily as it is iterated.
+// Requires C++20 coroutine support, LRANGES_HAS_COROUTINES is defined when available.
+template <typename T> struct generator {
+
+    using value_type = std::remove_cv_t<std::remove_reference_t<T>>;
+    using reference  = std::conditional_t<std::is_reference<T>::value, T, const value_type&>;
+    using pointer    = std::add_pointer_t<reference>;
+
+    struct promise_type {
+        generator get_return_object()
+        {
+            return generator { std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_always final_suspend() const noexcept { return {}; }
+
+        std::suspend_always yield_value(std::remove_reference_t<reference>& v) noexcept
+        {
+            current = std::addressof(v);
+            return {};
+        }
+        std::suspend_always yield_value(std::remove_reference_t<reference>&& v) noexcept
+        {
+            current = std::addressof(v);
+            return {};
+        }
+
+        void return_void() const noexcept {}
+        void unhandled_exception() { exception = std::current_exception(); }
+
+        template <typename U> void await_transform(U&&) = delete;
+
+        static void* operator new(std::size_t n) { return detail::FrameAllocator::allocate(n); }
+        static void  operator delete(void* p, std::size_t n) noexcept
+        {
+            detail::FrameAllocator::deallocate(p, n);
+        }
+
+        pointer            current = nullptr;
+        std::exception_ptr exception;
+        bool               started = false;
+    };
+
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    struct iterator {
+        using iterator_category = std::input_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = generator::value_type;
+        using reference         = generator::reference;
+        using pointer           = generator::pointer;
+
+        iterator() = default;
+        explicit iterator(handle_type h)
+            : coro { h }
+        {
+        }
+
+        reference operator*() const { return static_cast<reference>(*coro.promise().current); }
+        pointer   operator->() const { return coro.promise().current; }
+
+        iterator& operator++()
+        {
+            resume(coro);
+            return *this;
+        }
+        auto operator++(int) { return detail::post_increment(*this, std::true_type {}); }
+
+        bool operator==(const iterator& rhs) const { return done() == rhs.done(); }
+        bool operator!=(const iterator& rhs) const { return !((*this) == rhs); }
+
+    private:
+        bool done() const { return !coro || coro.done(); }
+
+        handle_type coro = nullptr;
+    };
+
+    generator(generator&& other) noexcept
+        : coro { std::exchange(other.coro, nullptr) }
+    {
+    }
+    generator& operator=(generator other) noexcept
+    {
+        std::swap(coro, other.coro);
+        return *this;
+    }
+    ~generator()
+    {
+        if (coro) {
+            coro.destroy();
+        }
+    }
+
+    /*the coroutine runs up to its first co_yield on the first call only, as the range is
+    single-pass. Like a borrowed range the generator is shallow-const: a const generator still
+    advances its coroutine, so it must not be iterated from several threads.*/
+    iterator begin() const
+    {
+        if (coro && !std::exchange(coro.promise().started, true)) {
+            resume(coro);
+        }
+        return iterator { coro };
+    }
+    iterator end() const { return iterator {}; }
+
+private:
+    explicit generator(handle_type h)
+        : coro { h }
+    {
+    }
+
+    static void resume(handle_type h)
+    {
+        h.resume();
+        if (h.promise().exception) {
+            std::rethrow_exception(std::exchange(h.promise().exception, nullptr));
+        }
+    }
+
+    handle_type coro = nullptr;
+};
+
+#endif
+
 } // namespace lranges
@@ -69,6 +69,24 @@ TEST_CASE("transform and filter by freestanding func", "[transform]")
     REQUIRE(res[4] == 7);
 }
 
+bool less_int(int l, int r) { return l < r; }
+int  add(int l, int r) { return l + r; }
+int  add_nothrow(int l, int r) noexcept { return l + r; }
+
+TEST_CASE("binary freestanding funcs", "[merge][top_k][reduce]")
+{
+    std::vector<int> a { 1, 4, 6 };
+    std::vector<int> b { 2, 3, 7 };
+    using namespace lranges;
+
+    auto merged = merge(a, b, less_int);
+    REQUIRE(std::vector<int>(merged.begin(), merged.end())
+        == (std::vector<int> { 1, 2, 3, 4, 6, 7 }));
+    REQUIRE((b | top_k(2, less_int)) == (std::vector<int> { 2, 3 }));
+    REQUIRE((a | reduce(0, add)) == 11);
+    REQUIRE((b | reduce(0, add_nothrow)) == 12);
+}
+
 TEST_CASE("transform and filter by freestanding ptr to mem", "[transform]")
 {
     struct Baz {
@@ -133,3 +151,50 @@ TEST_CASE("Sample")
     REQUIRE(res[0] == 5);
     REQUIRE(res[1] == 9);
 }
+
+struct isEvenConst {
+    constexpr bool operator()(int val) const { return val % 2 == 0; }
+};
+
+struct MulConst {
+    constexpr int operator()(int val) const { return val * 2 + 1; }
+};
+
+constexpr int plus_1_const(int val) { return val + 1; }
+
+static constexpr int table_source[] = { 1, 2, 3, 4, 5, 6 };
+
+TEST_CASE("Compile time table generation", "[constexpr]")
+{
+    using lranges::filter;
+    using lranges::make_iterator_range;
+    using lranges::to_array;
+    using lranges::transform;
+
+    constexpr auto table = make_iterator_range(std::begin(table_source), std::end(table_source))
+        | filter(isEvenConst {}) | transform(MulConst {}) | transform(plus_1_const)
+        | to_array<4>();
+
+    static_assert(std::is_same<decltype(table), const std::array<int, 4>>::value, "array terminal");
+    static_assert(table[0] == 6, "evaluated at compile time");
+    static_assert(table[1] == 10, "evaluated at compile time");
+    static_assert(table[2] == 14, "evaluated at compile time");
+    static_assert(table[3] == 0, "missing elements are value initialized");
+
+    constexpr auto truncated = make_iterator_range(std::begin(table_source), std::end(table_source))
+        | to_array<2>();
+    static_assert(truncated.size() == 2 && truncated[1] == 2, "truncates to N");
+
+#if __cplusplus >= 201703L
+    constexpr std::array<int, 4> arr { 1, 2, 3, 4 };
+    constexpr auto from_array
+        = arr | filter(isEvenConst {}) | transform(MulConst {}) | to_array<2>();
+    static_assert(from_array[0] == 5 && from_array[1] == 9, "std::array sources in C++17");
+#endif
+
+    std::vector<int> vec { 1, 2, 3 };
+    auto res = vec | transform([](int val) { return val * 10; }) | to_array<3>();
+    REQUIRE(res[0] == 10);
+    REQUIRE(res[1] == 20);
+    REQUIRE(res[2] == 30);
+}
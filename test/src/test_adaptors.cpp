@@ -0,0 +1,369 @@
+#include <catch2/catch.hpp>
+
+#include <lranges.h>
+
+#include <algorithm>
+#include <list>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+TEST_CASE("Reverse iterates back to front", "[reverse]")
+{
+    std::vector<int> vec { 1, 2, 3, 4, 5, 6 };
+    using namespace lranges;
+
+    auto rev = vec | reverse();
+    REQUIRE(std::vector<int>(rev.begin(), rev.end()) == (std::vector<int> { 6, 5, 4, 3, 2, 1 }));
+
+    auto pipeline = vec | transform([](int v) { return v * 10; }) | reverse();
+    static_assert(std::is_same<std::iterator_traits<decltype(pipeline.begin())>::iterator_category,
+                      std::random_access_iterator_tag>::value,
+        "keeps iterator category");
+    REQUIRE(pipeline.begin()[1] == 50);
+    REQUIRE(std::vector<int>(pipeline.begin(), pipeline.end())
+        == (std::vector<int> { 60, 50, 40, 30, 20, 10 }));
+
+    auto twice = vec | filter([](int v) { return v > 2; }) | reverse() | reverse();
+    REQUIRE(std::vector<int>(twice.begin(), twice.end()) == (std::vector<int> { 3, 4, 5, 6 }));
+
+    std::list<int> list { 1, 2, 3 };
+    auto           rlist = list | reverse() | transform([](int v) { return v + 1; });
+    REQUIRE(std::vector<int>(rlist.begin(), rlist.end()) == (std::vector<int> { 4, 3, 2 }));
+}
+
+TEST_CASE("Reverse scans filters from the end of the source", "[reverse][filter]")
+{
+    std::vector<int> vec(1000);
+    for (int i = 0; i < 1000; ++i) {
+        vec[i] = i;
+    }
+    using namespace lranges;
+
+    int  calls  = 0;
+    auto latest = vec | filter([&calls](int v) {
+        ++calls;
+        return v % 10 == 0;
+    }) | transform([](int v) { return v / 10; })
+        | reverse();
+
+    auto it = latest.begin();
+    REQUIRE(*it == 99);
+    REQUIRE(*++it == 98);
+    REQUIRE(*++it == 97);
+    REQUIRE(calls == 30);
+
+    --it;
+    REQUIRE(*it == 98);
+}
+
+TEST_CASE("Filter iterator decrement skips non matching elements", "[filter][iterator]")
+{
+    std::vector<int> vec { 1, 2, 3, 4, 5 };
+    using namespace lranges;
+
+    auto even = vec | filter([](int v) { return v % 2 == 0; });
+    auto it   = even.end();
+    REQUIRE(*--it == 4);
+    REQUIRE(*--it == 2);
+    REQUIRE(it == even.begin());
+}
+
+TEST_CASE("Lazy merge of sorted ranges", "[set][merge]")
+{
+    std::vector<int> a { 1, 3, 5, 7 };
+    std::list<int>   b { 2, 3, 6 };
+    using namespace lranges;
+
+    auto merged = merge(a, b);
+    static_assert(std::is_same<std::iterator_traits<decltype(merged.begin())>::iterator_category,
+                      std::forward_iterator_tag>::value,
+        "caps at forward iterator category");
+    REQUIRE(std::vector<int>(merged.begin(), merged.end())
+        == (std::vector<int> { 1, 2, 3, 3, 5, 6, 7 }));
+
+    auto doubled = merge(a | filter([](int v) { return v > 1; }), b)
+        | transform([](int v) { return v * 2; });
+    REQUIRE(std::vector<int>(doubled.begin(), doubled.end())
+        == (std::vector<int> { 4, 6, 6, 10, 12, 14 }));
+
+    auto descending
+        = merge(std::vector<int> { 9, 4 }, std::vector<int> { 5, 1 }, std::greater<> {});
+    REQUIRE(std::vector<int>(descending.begin(), descending.end())
+        == (std::vector<int> { 9, 5, 4, 1 }));
+}
+
+TEST_CASE("Lazy intersection and difference of sorted ranges", "[set]")
+{
+    std::vector<int> a { 1, 2, 2, 4, 6, 8, 9 };
+    std::list<int>   b { 2, 2, 3, 4, 9, 10 };
+    using namespace lranges;
+
+    auto common = set_intersect(a, b);
+    REQUIRE(std::vector<int>(common.begin(), common.end()) == (std::vector<int> { 2, 2, 4, 9 }));
+
+    auto only_a = set_difference(a, b);
+    REQUIRE(std::vector<int>(only_a.begin(), only_a.end()) == (std::vector<int> { 1, 6, 8 }));
+
+    auto only_b = set_difference(b, a);
+    REQUIRE(std::vector<int>(only_b.begin(), only_b.end()) == (std::vector<int> { 3, 10 }));
+
+    std::vector<int> empty;
+    auto             none = set_intersect(a, empty);
+    REQUIRE(none.begin() == none.end());
+    auto all = set_difference(a, empty);
+    REQUIRE(std::distance(all.begin(), all.end()) == 7);
+}
+
+TEST_CASE("Intersection gallops over random-access ranges", "[set][galloping]")
+{
+    std::vector<int> large(1000000);
+    for (int i = 0; i < 1000000; ++i) {
+        large[i] = i * 2;
+    }
+    std::vector<int> small { 10, 5000, 5001, 777778, 1999998 };
+    using namespace lranges;
+
+    int  comparisons = 0;
+    auto counting    = [&comparisons](int l, int r) {
+        ++comparisons;
+        return l < r;
+    };
+    auto common = set_intersect(small, large, counting);
+    REQUIRE(std::vector<int>(common.begin(), common.end())
+        == (std::vector<int> { 10, 5000, 777778, 1999998 }));
+    REQUIRE(comparisons < 1000);
+
+    comparisons = 0;
+    auto rest   = set_difference(small, large, counting);
+    REQUIRE(std::vector<int>(rest.begin(), rest.end()) == (std::vector<int> { 5001 }));
+    REQUIRE(comparisons < 1000);
+}
+
+TEST_CASE("Distinct drops repeated keys", "[distinct]")
+{
+    std::vector<int> vec { 3, 1, 3, 2, 1, 4, 2, 5 };
+    using namespace lranges;
+
+    auto unique = vec | distinct();
+    static_assert(std::is_same<std::iterator_traits<decltype(unique.begin())>::iterator_category,
+                      std::input_iterator_tag>::value,
+        "distinct is single-pass");
+    REQUIRE(std::vector<int>(unique.begin(), unique.end()) == (std::vector<int> { 3, 1, 2, 4, 5 }));
+    // every traversal starts with an empty set of seen keys
+    REQUIRE(std::vector<int>(unique.begin(), unique.end()) == (std::vector<int> { 3, 1, 2, 4, 5 }));
+
+    auto by_parity = vec | transform([](int v) { return v * 10; })
+        | distinct([](int v) { return v % 20; });
+    REQUIRE(std::vector<int>(by_parity.begin(), by_parity.end()) == (std::vector<int> { 30, 20 }));
+
+    std::vector<std::string> words { "b", "a", "b", "c", "a" };
+    auto                     unique_words = words | distinct();
+    REQUIRE(std::vector<std::string>(unique_words.begin(), unique_words.end())
+        == (std::vector<std::string> { "b", "a", "c" }));
+}
+
+TEST_CASE("Distinct on sorted input keeps no set", "[distinct]")
+{
+    std::list<int> sorted { 1, 1, 2, 3, 3, 3, 7 };
+    using namespace lranges;
+
+    auto unique = sorted | distinct_sorted();
+    static_assert(std::is_same<std::iterator_traits<decltype(unique.begin())>::iterator_category,
+                      std::forward_iterator_tag>::value,
+        "multi-pass");
+    REQUIRE(std::vector<int>(unique.begin(), unique.end()) == (std::vector<int> { 1, 2, 3, 7 }));
+
+    auto by_tens = std::vector<int> { 1, 5, 12, 18, 19, 30 }
+        | distinct_sorted([](int v) { return v / 10; }) | transform([](int v) { return -v; });
+    REQUIRE(
+        std::vector<int>(by_tens.begin(), by_tens.end()) == (std::vector<int> { -1, -12, -30 }));
+
+    std::vector<int> empty;
+    auto             none = empty | distinct_sorted();
+    REQUIRE(none.begin() == none.end());
+}
+
+TEST_CASE("Flat hash set", "[distinct][flat_hash_set]")
+{
+    lranges::flat_hash_set<int> set(4);
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(set.insert(i % 100).second == (i < 100));
+    }
+    REQUIRE(set.size() == 100);
+    REQUIRE(set.count(42) == 1);
+    REQUIRE(set.count(420) == 0);
+    REQUIRE(*set.begin() == 0);
+}
+
+TEST_CASE("Shared and borrowed sources make pipeline copies cheap", "[ownership]")
+{
+    using namespace lranges;
+    auto twice = [](int v) { return 2 * v; };
+
+    auto owned      = std::vector<int>(1000, 1) | transform(twice);
+    auto owned_copy = owned;
+    REQUIRE(&owned_copy.source() != &owned.source());
+    static_assert(ownership_of<decltype(owned)>::value == ownership::owned, "owned");
+
+    auto shared      = share(std::vector<int>(1000, 1)) | transform(twice);
+    auto shared_copy = shared;
+    REQUIRE(&shared_copy.source() == &shared.source());
+    REQUIRE(std::vector<int>(shared_copy.begin(), shared_copy.end()) == std::vector<int>(1000, 2));
+    static_assert(ownership_of<decltype(shared)>::value == ownership::shared, "shared");
+
+    std::vector<int> vec { 3, 1, 2 };
+    auto             borrowed = borrow(vec) | filter([](int v) { return v != 1; }) | reverse();
+    auto             copy     = borrowed;
+    REQUIRE(std::vector<int>(copy.begin(), copy.end()) == (std::vector<int> { 2, 3 }));
+    REQUIRE(&(vec | transform(twice)).source() == &vec);
+    static_assert(ownership_of<decltype(borrowed)>::value == ownership::borrowed, "borrowed");
+    static_assert(ownership_of<decltype(vec | transform(twice))>::value == ownership::borrowed,
+        "lvalues are borrowed");
+    static_assert(ownership_of<decltype(owned | filter(twice))>::value == ownership::borrowed,
+        "a pipeline piped as lvalue is borrowed");
+
+    static_assert(
+        ownership_of<decltype(merge(vec, share(std::vector<int> {})))>::value == ownership::shared,
+        "the most expensive source decides");
+    static_assert(
+        ownership_of<decltype(merge(vec, std::vector<int> {}))>::value == ownership::owned,
+        "the most expensive source decides");
+}
+
+TEST_CASE("Reversing an lvalue pipeline borrows its owned source", "[ownership][reverse]")
+{
+    using namespace lranges;
+
+    auto pipeline = std::vector<int> { 1, 2, 3 } | transform([](int v) { return v; });
+    auto reversed = pipeline | reverse();
+    static_assert(ownership_of<decltype(reversed)>::value == ownership::borrowed, "borrowed");
+    pipeline.source()[2] = 42;
+    REQUIRE(*reversed.begin() == 42);
+
+    auto filtered = std::vector<int> { 1, 2, 3 } | filter([](int v) { return v != 2; });
+    auto back     = filtered | reverse();
+
+    filtered.source()[0] = 7;
+    REQUIRE(std::vector<int>(back.begin(), back.end()) == (std::vector<int> { 3, 7 }));
+
+    auto owned = std::vector<int> { 1, 2, 3 } | transform([](int v) { return v; }) | reverse();
+    static_assert(ownership_of<decltype(owned)>::value == ownership::owned, "rvalues are moved");
+    REQUIRE(*owned.begin() == 3);
+}
+
+TEST_CASE("Shared pipeline passed to a task", "[ownership]")
+{
+    using namespace lranges;
+
+    auto pipeline = share(std::vector<int>(10000, 1)) | filter([](int v) { return v > 0; });
+    auto task     = [pipeline] { return pipeline | reduce(0, std::plus<> {}); };
+    REQUIRE(task() == 10000);
+
+    auto view = materialize(share(std::vector<int> { 1, 2, 3 }) | transform([](int v) {
+        return v * 10;
+    }));
+    REQUIRE(std::vector<int>(view.begin(), view.end()) == (std::vector<int> { 10, 20, 30 }));
+}
+
+TEST_CASE("Sliding window with invertible reducers", "[sliding]")
+{
+    std::vector<int> vec(50);
+    std::iota(vec.begin(), vec.end(), 1);
+    using namespace lranges;
+
+    int  calls  = 0;
+    auto sums   = vec | sliding(10, sum([&](int v) {
+        ++calls;
+        return v;
+    }));
+    auto result = std::vector<int>(sums.begin(), sums.end());
+    REQUIRE(result.size() == 41);
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        REQUIRE(result[i] == std::accumulate(vec.begin() + i, vec.begin() + i + 10, 0));
+    }
+    // every element is projected once when it enters the window
+    REQUIRE(calls == 50);
+
+    static_assert(std::is_same<std::iterator_traits<decltype(sums.begin())>::iterator_category,
+                      std::random_access_iterator_tag>::value,
+        "random access is kept");
+    REQUIRE(sums.end() - sums.begin() == 41);
+    REQUIRE(sums.begin()[20] == result[20]);
+    REQUIRE(*(sums.end() - 1) == result.back());
+    auto it = sums.begin() + 30;
+    REQUIRE(*(--it) == result[29]);
+    it -= 25;
+    REQUIRE(*it == result[4]);
+
+    // walking back projects the element entering at the front, the end only rebuilds once
+    auto first = sums.begin();
+    calls      = 0;
+    it         = sums.end();
+    for (auto i = result.size(); i-- > 0;) {
+        REQUIRE(*(--it) == result[i]);
+    }
+    REQUIRE(calls == 50);
+    REQUIRE(it == first);
+    it += 20;
+    calls = 0;
+    it -= 9;
+    REQUIRE(*it == result[11]);
+    REQUIRE(calls == 9);
+
+    auto counts = vec | filter([](int v) { return v % 3 == 0; }) | sliding(4, count());
+    REQUIRE(std::vector<std::size_t>(counts.begin(), counts.end())
+        == std::vector<std::size_t>(13, 4));
+
+    auto none = vec | sliding(51, sum());
+    REQUIRE(none.begin() == none.end());
+    auto empty = vec | sliding(0, sum());
+    REQUIRE(empty.begin() == empty.end());
+}
+
+TEST_CASE("Sliding window with non-invertible reducers", "[sliding]")
+{
+    std::mt19937                       gen(42);
+    std::uniform_int_distribution<int> dist(-1000, 1000);
+    std::list<int>                     lst;
+    for (int i = 0; i < 500; ++i) {
+        lst.push_back(dist(gen));
+    }
+    std::vector<int> vec(lst.begin(), lst.end());
+    using namespace lranges;
+
+    for (std::size_t w : { 1, 2, 5, 17, 100, 500 }) {
+        auto lows  = lst | sliding(w, min());
+        auto highs = lst | sliding(w, max());
+        static_assert(std::is_same<std::iterator_traits<decltype(lows.begin())>::iterator_category,
+                          std::forward_iterator_tag>::value,
+            "bidirectional sources are only traversed forward");
+        auto low  = lows.begin();
+        auto high = highs.begin();
+        for (std::size_t i = 0; i + w <= vec.size(); ++i, ++low, ++high) {
+            REQUIRE(*low == *std::min_element(vec.begin() + i, vec.begin() + i + w));
+            REQUIRE(*high == *std::max_element(vec.begin() + i, vec.begin() + i + w));
+        }
+        REQUIRE(low == lows.end());
+        REQUIRE(high == highs.end());
+    }
+
+    int  calls = 0;
+    auto highs = vec | sliding(100, max([&](int v) {
+        ++calls;
+        return v;
+    }));
+    for (auto it = highs.begin(); it != highs.end(); ++it) {
+        (void)*it;
+    }
+    REQUIRE(calls == 500);
+
+    auto big_first = std::vector<double> { 1e16, 1, 1, 1, 1 } | sliding(2, sum());
+    REQUIRE(std::vector<double>(big_first.begin(), big_first.end())
+        == (std::vector<double> { 1e16 + 1, 2, 2, 2 }));
+
+    auto windows = std::vector<int> { 1, 2, 3, 4, 5 } | sliding(3, collect());
+    REQUIRE(std::vector<std::vector<int>>(windows.begin(), windows.end())
+        == (std::vector<std::vector<int>> { { 1, 2, 3 }, { 2, 3, 4 }, { 3, 4, 5 } }));
+}
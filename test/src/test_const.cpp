@@ -0,0 +1,62 @@
+#include <catch2/catch.hpp>
+
+#include <lranges.h>
+
+#include <numeric>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Const pipelines hand out const iterators", "[const][iterator]")
+{
+    const std::vector<int> vec { 1, 2, 3, 4, 5, 6 };
+    using namespace lranges;
+
+    const auto pipeline = vec | transform([](int v) { return v * 2; })
+        | filter([](int v) { return v > 4; }) | transform([](int v) { return v + 1; });
+
+    using iterator = decltype(pipeline.begin());
+    static_assert(std::is_same<iterator, std::decay_t<decltype(pipeline)>::const_iterator>::value,
+        "const begin yields const_iterator");
+    static_assert(std::is_same<std::iterator_traits<iterator>::iterator_category,
+                      std::bidirectional_iterator_tag>::value,
+        "keeps iterator category");
+
+    REQUIRE(std::vector<int>(pipeline.begin(), pipeline.end())
+        == (std::vector<int> { 7, 9, 11, 13 }));
+
+    const auto squares = std::vector<int> { 1, 2, 3 } | transform([](int v) { return v * v; });
+    auto       it      = squares.begin();
+    REQUIRE(it[2] == 9);
+    REQUIRE(*(it + 1) == 4);
+    const auto& const_it = it;
+    REQUIRE(const_it[1] == 4);
+}
+
+TEST_CASE("Const pipeline shared across threads", "[const][parallel]")
+{
+    std::vector<int> data(100000);
+    std::iota(data.begin(), data.end(), 0);
+    const auto& source = data;
+    using namespace lranges;
+
+    const auto pipeline = source | filter([](int v) { return v % 3 == 0; })
+        | transform([](int v) { return static_cast<long long>(v) * 2; });
+
+    std::vector<long long>   sums(4);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < sums.size(); ++i) {
+        threads.emplace_back([&pipeline, &sums, i] {
+            sums[i] = std::accumulate(pipeline.begin(), pipeline.end(), 0LL);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    long long expected = 0;
+    for (auto v : data) {
+        expected += v % 3 == 0 ? v * 2LL : 0;
+    }
+    for (auto sum : sums) {
+        REQUIRE(sum == expected);
+    }
+}
@@ -0,0 +1,127 @@
+#include <catch2/catch.hpp>
+
+#include <lranges.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(LRANGES_HAS_COROUTINES)
+
+namespace {
+lranges::generator<int> iota(int from, int to)
+{
+    for (int i = from; i < to; ++i) {
+        co_yield i;
+    }
+}
+
+lranges::generator<std::string> pages(int count)
+{
+    for (int i = 0; i < count; ++i) {
+        std::string page = "page" + std::to_string(i);
+        co_yield page;
+    }
+}
+
+lranges::generator<int> failing()
+{
+    co_yield 1;
+    throw std::runtime_error("decoder failure");
+}
+} // namespace
+
+TEST_CASE("Generator composes with transform and filter", "[generator]")
+{
+    using namespace lranges;
+
+    auto squares = iota(0, 10) | filter([](int v) { return v % 2 == 1; })
+        | transform([](int v) { return v * v; });
+    static_assert(std::is_same<std::iterator_traits<decltype(squares.begin())>::iterator_category,
+                      std::input_iterator_tag>::value,
+        "generators are single-pass");
+    REQUIRE(std::vector<int>(squares.begin(), squares.end())
+        == (std::vector<int> { 1, 9, 25, 49, 81 }));
+
+    auto gen   = pages(3);
+    auto sizes = gen | transform([](const std::string& s) { return s.size(); });
+    REQUIRE(std::vector<std::size_t>(sizes.begin(), sizes.end())
+        == (std::vector<std::size_t> { 5, 5, 5 }));
+    REQUIRE(gen.begin() == gen.end());
+
+    auto empty = iota(3, 3);
+    REQUIRE(empty.begin() == empty.end());
+}
+
+TEST_CASE("Generator feeds terminals", "[generator]")
+{
+    using namespace lranges;
+
+    auto stats = iota(1, 101) | fan_out(count(), sum(), max());
+    REQUIRE(std::get<0>(stats) == 100);
+    REQUIRE(std::get<1>(stats) == 5050);
+    REQUIRE(std::get<2>(stats) == 100);
+
+    REQUIRE((iota(0, 1000) | top_k(2)) == (std::vector<int> { 999, 998 }));
+}
+
+TEST_CASE("Generator iterator supports post increment", "[generator]")
+{
+    auto             gen = iota(0, 4);
+    std::vector<int> values;
+    for (auto it = gen.begin(); it != gen.end();) {
+        values.push_back(*it++);
+    }
+    REQUIRE(values == (std::vector<int> { 0, 1, 2, 3 }));
+
+    auto names = pages(2);
+    auto it    = names.begin();
+    REQUIRE(*it++ == "page0");
+    REQUIRE(*it == "page1");
+
+    using namespace lranges;
+    auto tens = iota(0, 4) | transform([](int v) { return v * 10; });
+    auto ten  = tens.begin();
+    REQUIRE(*ten++ == 0);
+    REQUIRE(*ten++ == 10);
+    REQUIRE(*ten == 20);
+
+    auto all   = iota(0, 4) | filter([](int) { return true; });
+    auto first = all.begin();
+    REQUIRE(*first++ == 0);
+    REQUIRE(*first == 1);
+
+    auto unique = iota(0, 4) | distinct();
+    auto next   = unique.begin();
+    REQUIRE(*next++ == 0);
+    REQUIRE(*next == 1);
+}
+
+TEST_CASE("Generator rethrows exceptions of the coroutine", "[generator]")
+{
+    auto gen = failing();
+    auto it  = gen.begin();
+    REQUIRE(*it == 1);
+    REQUIRE_THROWS_AS(++it, std::runtime_error);
+}
+
+TEST_CASE("Generator frames are recycled", "[generator]")
+{
+    const void* first_frame = nullptr;
+    {
+        auto gen    = iota(0, 1);
+        first_frame = &*gen.begin();
+    }
+    // the frame of the destroyed generator is handed out again from the free list
+    auto gen = iota(0, 1);
+    REQUIRE(&*gen.begin() == first_frame);
+}
+
+TEST_CASE("Generator frames released at exit", "[generator]")
+{
+    // destroyed after the free lists of the main thread
+    static auto gen = iota(0, 3);
+    REQUIRE(*gen.begin() == 0);
+}
+
+#endif
@@ -0,0 +1,400 @@
+#include <catch2/catch.hpp>
+
+#include <lranges.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <forward_list>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Materialized view evaluates only appended elements", "[materialize]")
+{
+    std::vector<int> vec { 1, 2, 3, 4 };
+    using namespace lranges;
+
+    int  evaluated = 0;
+    auto view      = materialize(
+        vec | transform([](int v) { return v * 10; }) | filter([&evaluated](int v) {
+            ++evaluated;
+            return v % 20 == 0;
+        }));
+
+    REQUIRE(evaluated == 4);
+    REQUIRE(view.size() == 2);
+    REQUIRE(view[0] == 20);
+    REQUIRE(view[1] == 40);
+
+    vec.push_back(5);
+    vec.push_back(6);
+    view.refresh();
+    REQUIRE(evaluated == 6);
+    REQUIRE(view.size() == 3);
+    REQUIRE(view[2] == 60);
+    REQUIRE(view.data() + 2 == &view[2]);
+
+    view.refresh();
+    REQUIRE(evaluated == 6);
+    REQUIRE(view.size() == 3);
+
+    std::vector<int> res(view.begin(), view.end());
+    REQUIRE(res == (std::vector<int> { 20, 40, 60 }));
+}
+
+TEST_CASE("Materialized view over a deque", "[materialize]")
+{
+    std::deque<int> dq;
+    using namespace lranges;
+
+    auto view = materialize(dq | filter([](int v) { return v > 1; }));
+    REQUIRE(view.empty());
+
+    dq.push_back(1);
+    dq.push_back(2);
+    view.refresh();
+    REQUIRE(view.size() == 1);
+    REQUIRE(view[0] == 2);
+
+    dq.push_back(3);
+    view.refresh();
+    REQUIRE(view.size() == 2);
+    REQUIRE(view[1] == 3);
+}
+
+TEST_CASE("Materialized view over a list", "[materialize]")
+{
+    std::list<int> lst;
+    using namespace lranges;
+
+    int  evaluated = 0;
+    auto view      = materialize(lst | filter([&evaluated](int v) {
+        ++evaluated;
+        return v % 2 == 0;
+    }) | transform([](int v) { return v / 2; }));
+    REQUIRE(view.empty());
+
+    for (int batch = 0; batch < 10; ++batch) {
+        for (int i = 0; i < 100; ++i) {
+            lst.push_back(batch * 100 + i);
+        }
+        view.refresh();
+        REQUIRE(evaluated == (batch + 1) * 100);
+        REQUIRE(view.size() == std::size_t((batch + 1) * 50));
+        REQUIRE(view[view.size() - 1] == batch * 50 + 49);
+    }
+    view.refresh();
+    REQUIRE(evaluated == 1000);
+}
+
+namespace {
+struct Order {
+    int    customer;
+    double amount;
+};
+} // namespace
+
+TEST_CASE("Group by key with reducers", "[group_by]")
+{
+    std::vector<int> vec { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    using namespace lranges;
+
+    auto counts = vec | filter([](int v) { return v > 2; })
+        | group_by([](int v) { return v % 3; }, count());
+    REQUIRE(counts.size() == 3);
+    REQUIRE(counts[0] == 3);
+    REQUIRE(counts[1] == 3);
+    REQUIRE(counts[2] == 2);
+
+    auto sums = vec | transform([](int v) { return v * 2; })
+        | group_by([](int v) { return v % 4; }, sum());
+    static_assert(std::is_same<decltype(sums), flat_hash_map<int, int>>::value, "int sums");
+    REQUIRE(sums.size() == 2);
+    REQUIRE(sums[0] == 60);
+    REQUIRE(sums[2] == 50);
+
+    auto minmax = vec | group_by([](int v) { return v % 2 == 0; }, max());
+    REQUIRE(minmax[true] == 10);
+    REQUIRE(minmax[false] == 9);
+    REQUIRE((vec | group_by([](int v) { return v > 5; }, min()))[true] == 6);
+
+    std::vector<Order> orders { { 1, 10.0 }, { 2, 5.0 }, { 1, 2.5 }, { 3, 1.0 }, { 2, 0.5 } };
+    auto per_customer = orders
+        | group_by([](const Order& o) { return o.customer; },
+            sum([](const Order& o) { return o.amount; }));
+    REQUIRE(per_customer.size() == 3);
+    REQUIRE(per_customer[1] == 12.5);
+    REQUIRE(per_customer[2] == 5.5);
+    REQUIRE(per_customer[3] == 1.0);
+    REQUIRE(per_customer.begin()->first == 1);
+}
+
+TEST_CASE("Flat hash map grows past its initial capacity", "[group_by][flat_hash_map]")
+{
+    lranges::flat_hash_map<int, int> map;
+    REQUIRE(map.find(1) == map.end());
+    for (int i = 0; i < 10000; ++i) {
+        map[i * 1024] = i;
+    }
+    REQUIRE(map.size() == 10000);
+    for (int i = 0; i < 10000; ++i) {
+        REQUIRE(map.find(i * 1024) != map.end());
+        REQUIRE(map.find(i * 1024)->second == i);
+    }
+    REQUIRE(map.count(3) == 0);
+    REQUIRE(!map.try_emplace(0, 42).second);
+    REQUIRE(map[0] == 0);
+}
+
+TEST_CASE("Flat hash map survives a throwing constructor", "[group_by][flat_hash_map]")
+{
+    struct Checked {
+        explicit Checked(int v)
+            : value { v }
+        {
+            if (v < 0) {
+                throw std::invalid_argument("negative");
+            }
+        }
+        int value;
+    };
+
+    lranges::flat_hash_map<int, Checked> map;
+    REQUIRE_THROWS_AS(map.try_emplace(1, -1), std::invalid_argument);
+    REQUIRE(map.empty());
+    REQUIRE(map.find(1) == map.end());
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(map.try_emplace(i, i).second);
+    }
+    REQUIRE_THROWS_AS(map.try_emplace(100, -1), std::invalid_argument);
+    REQUIRE(map.find(100) == map.end());
+    REQUIRE(map.size() == 100);
+    REQUIRE(map.find(1)->second.value == 1);
+}
+
+TEST_CASE("Parallel group by merges partial tables", "[group_by][parallel]")
+{
+    std::vector<int> vec(10000);
+    std::iota(vec.begin(), vec.end(), 0);
+    using namespace lranges;
+
+    auto key        = [](int v) { return v % 7; };
+    auto sequential = vec | transform([](int v) { return v + 1; }) | group_by(key, sum());
+    auto parallel   = vec | transform([](int v) { return v + 1; })
+        | group_by(parallel_policy { 4 }, key, sum());
+    REQUIRE(parallel.size() == sequential.size());
+    for (auto& group : sequential) {
+        REQUIRE(parallel[group.first] == group.second);
+    }
+    auto counts = vec | group_by(par, key, count());
+    REQUIRE(counts[0] == 1429);
+    REQUIRE(counts[6] == 1428);
+}
+
+TEST_CASE("Parallel group by over filtered pipelines", "[group_by][parallel]")
+{
+    std::vector<int> vec(10000);
+    std::iota(vec.begin(), vec.end(), 0);
+    std::list<int> lst(vec.begin(), vec.end());
+    using namespace lranges;
+
+    auto odd      = [](int v) { return v % 2 == 1; };
+    auto key      = [](int v) { return v % 3; };
+    auto from_v   = vec | filter(odd) | group_by(parallel_policy { 4 }, key, count());
+    auto from_l   = lst | filter(odd) | transform([](int v) { return v; })
+        | group_by(parallel_policy { 4 }, key, count());
+    auto expected = vec | filter(odd) | group_by(key, count());
+    REQUIRE(from_v.size() == 3);
+    REQUIRE(from_l.size() == 3);
+    for (auto& group : expected) {
+        REQUIRE(from_v[group.first] == group.second);
+        REQUIRE(from_l[group.first] == group.second);
+    }
+
+    std::vector<int> empty;
+    REQUIRE((empty | filter(odd) | group_by(par, key, count())).size() == 0);
+}
+
+TEST_CASE("Top k keeps only k elements", "[top_k]")
+{
+    std::vector<int> vec { 5, 1, 9, 3, 7, 8, 2, 6, 4, 0 };
+    using namespace lranges;
+
+    auto largest = vec | filter([](int v) { return v != 9; }) | top_k(3);
+    REQUIRE(largest == (std::vector<int> { 8, 7, 6 }));
+
+    auto smallest = vec | transform([](int v) { return v * 10; }) | top_k(2, std::less<> {});
+    REQUIRE(smallest == (std::vector<int> { 0, 10 }));
+
+    REQUIRE((vec | top_k(0)).empty());
+    REQUIRE((vec | top_k(20)).size() == vec.size());
+    REQUIRE((vec | top_k(std::size_t(1) << 40)).size() == vec.size());
+    REQUIRE((vec | top_k(parallel_policy { 4 }, std::size_t(1) << 40)).size() == vec.size());
+}
+
+TEST_CASE("Top k on input iterators", "[top_k][input]")
+{
+    std::istringstream         iss("4 12 7 1 9");
+    std::istream_iterator<int> begin { iss };
+    std::istream_iterator<int> end {};
+    using namespace lranges;
+
+    auto res = make_iterator_range(begin, end) | top_k(2);
+    REQUIRE(res == (std::vector<int> { 12, 9 }));
+}
+
+TEST_CASE("Parallel top k merges partial heaps", "[top_k][parallel]")
+{
+    std::vector<int> vec(10000);
+    std::iota(vec.begin(), vec.end(), 0);
+    std::reverse(vec.begin() + 5000, vec.end());
+    using namespace lranges;
+
+    auto by_last_digit = [](int l, int r) {
+        return l % 10 > r % 10 || (l % 10 == r % 10 && l < r);
+    };
+    auto sequential    = vec | top_k(5, by_last_digit);
+    auto parallel      = vec | top_k(parallel_policy { 4 }, 5, by_last_digit);
+    REQUIRE(parallel == sequential);
+    REQUIRE(parallel == (std::vector<int> { 9, 19, 29, 39, 49 }));
+}
+
+TEST_CASE("Parallel top k over filtered ranges", "[top_k][parallel]")
+{
+    std::vector<int> vec(5000);
+    std::iota(vec.begin(), vec.end(), 0);
+    std::list<int> lst(vec.begin(), vec.end());
+    using namespace lranges;
+
+    auto odd      = [](int v) { return v % 2 == 1; };
+    auto expected = vec | filter(odd) | top_k(10);
+    REQUIRE(expected.front() == 4999);
+    REQUIRE((vec | filter(odd) | top_k(parallel_policy { 4 }, 10)) == expected);
+    REQUIRE((lst | filter(odd) | top_k(parallel_policy { 4 }, 10)) == expected);
+}
+
+TEST_CASE("Fan out evaluates the pipeline once", "[fan_out]")
+{
+    std::vector<int> vec { 4, 8, 1, 6, 3 };
+    using namespace lranges;
+
+    int  evaluated = 0;
+    auto results   = vec | transform([&evaluated](int v) {
+        ++evaluated;
+        return v * 2;
+    }) | fan_out(count(), sum(), min(), max(), collect_if([](int v) { return v > 10; }));
+
+    REQUIRE(evaluated == 5);
+    REQUIRE(std::get<0>(results) == 5);
+    REQUIRE(std::get<1>(results) == 44);
+    REQUIRE(std::get<2>(results) == 2);
+    REQUIRE(std::get<3>(results) == 16);
+    REQUIRE(std::get<4>(results) == (std::vector<int> { 16, 12 }));
+
+    auto empty = vec | filter([](int v) { return v > 100; }) | fan_out(count(), sum(), collect());
+    REQUIRE(std::get<0>(empty) == 0);
+    REQUIRE(std::get<1>(empty) == 0);
+    REQUIRE(std::get<2>(empty).empty());
+}
+
+TEST_CASE("Fan out on input iterators", "[fan_out][input]")
+{
+    std::istringstream         iss("3 1 4 1 5");
+    std::istream_iterator<int> begin { iss };
+    std::istream_iterator<int> end {};
+    using namespace lranges;
+
+    auto results = make_iterator_range(begin, end) | fan_out(count(), max(), collect());
+    REQUIRE(std::get<0>(results) == 5);
+    REQUIRE(std::get<1>(results) == 5);
+    REQUIRE(std::get<2>(results) == (std::vector<int> { 3, 1, 4, 1, 5 }));
+}
+
+TEST_CASE("Parallel for each on a list keeps all workers busy", "[for_each][parallel]")
+{
+    std::list<int> lst(64);
+    std::iota(lst.begin(), lst.end(), 0);
+    using namespace lranges;
+
+    std::mutex                m;
+    std::set<std::thread::id> workers;
+    std::atomic<int>          total { 0 };
+    lst | filter([](int v) { return v % 2 == 0; })
+        | for_each(parallel_policy { 4 }, [&](int v) {
+              // a few elements are much more expensive than the others
+              if (v % 8 == 0) {
+                  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+              }
+              total += v;
+              std::lock_guard<std::mutex> lock(m);
+              workers.insert(std::this_thread::get_id());
+          });
+    REQUIRE(total == 992);
+    REQUIRE(workers.size() > 1);
+
+    int seen = 0;
+    lst | for_each([&](int v) { seen = v; });
+    REQUIRE(seen == 63);
+}
+
+TEST_CASE("Parallel for each evaluates the filter once per element", "[for_each][parallel]")
+{
+    std::list<int> lst(10000);
+    std::iota(lst.begin(), lst.end(), 0);
+    using namespace lranges;
+
+    std::atomic<int> calls { 0 };
+    std::atomic<int> matches { 0 };
+    auto             pipeline = lst | filter([&](int v) {
+        ++calls;
+        return v % 3 == 0;
+    });
+    pipeline | transform([](int v) { return v * 2; })
+        | for_each(parallel_policy { 4 }, [&](int v) { matches += v % 6 == 0; });
+    REQUIRE(calls == 10000);
+    REQUIRE(matches == 3334);
+
+    auto sum_of_matches = std::move(pipeline) | reduce(parallel_policy { 4 }, 0L, std::plus<> {});
+    REQUIRE(calls == 20000);
+    REQUIRE(sum_of_matches == 16668333L);
+}
+
+TEST_CASE("Parallel reduce over forward iterators", "[reduce][parallel]")
+{
+    std::forward_list<long> fl;
+    for (long i = 1; i <= 10000; ++i) {
+        fl.push_front(i);
+    }
+    using namespace lranges;
+
+    auto square     = [](long v) { return v * v; };
+    auto sequential = fl | transform(square) | reduce(0L, std::plus<> {});
+    auto parallel   = fl | transform(square) | reduce(parallel_policy { 4 }, 0L, std::plus<> {});
+    REQUIRE(sequential == 333383335000L);
+    REQUIRE(parallel == sequential);
+
+    auto largest = fl | reduce(par, 0L, [](long l, long r) { return std::max(l, r); });
+    REQUIRE(largest == 10000);
+
+    std::list<long> empty;
+    REQUIRE((empty | reduce(par, 42L, std::plus<> {})) == 42);
+}
+
+TEST_CASE("Parallel for each rethrows worker exceptions", "[for_each][parallel]")
+{
+    std::list<int> lst(1000, 1);
+    using namespace lranges;
+
+    REQUIRE_THROWS_AS(lst | for_each(parallel_policy { 4 }, [](int) {
+        throw std::runtime_error("worker failure");
+    }),
+        std::runtime_error);
+}